@@ -0,0 +1,77 @@
+#include "keywords.hpp"
+#include "lexer.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static TokenType mapKeywordType(std::string_view word) {
+    static const std::unordered_map<std::string, TokenType> keywords = {
+        {"fn", TokenType::Fn}, {"let", TokenType::Let},
+        {"if", TokenType::If}, {"else", TokenType::Else},
+        {"return", TokenType::Return}, {"print", TokenType::Print},
+        {"Int", TokenType::IntType}, {"Float", TokenType::FloatType},
+        {"String", TokenType::StringType}, {"Char", TokenType::CharType},
+        {"Bool", TokenType::BoolType}, {"Void", TokenType::VoidType},
+        {"true", TokenType::Bool}, {"false", TokenType::Bool},
+    };
+    auto it = keywords.find(std::string(word));
+    return it != keywords.end() ? it->second : TokenType::Identifier;
+}
+
+static std::string identifierHeavySource(size_t functions) {
+    std::string src;
+    for (size_t i = 0; i < functions; i++) {
+        std::string n = std::to_string(i);
+        src += "fn compute_" + n + "(alpha: Int, beta_value: Float) -> Int {\n";
+        src += "    let total_" + n + ": Int = alpha + helper_" + n + "(beta_value, gamma);\n";
+        src += "    if total_" + n + " <= limit { return total_" + n + "; } else { return fallback; }\n";
+        src += "}\n";
+    }
+    return src;
+}
+
+template <typename F>
+static double seconds(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t functions = argc > 1 ? std::stoul(argv[1]) : 200000;
+    std::string src = identifierHeavySource(functions);
+
+    std::vector<std::string_view> words;
+    {
+        Lexer lexer(src);
+        for (Token t = lexer.nextToken(); t.type != TokenType::Eof; t = lexer.nextToken())
+            if (t.type == TokenType::Identifier || keywordType(t.lexeme) != TokenType::Identifier)
+                words.push_back(t.lexeme);
+    }
+
+    size_t sink = 0;
+    double mapTime = seconds([&] {
+        for (auto w : words) sink += static_cast<size_t>(mapKeywordType(w));
+    });
+    double switchTime = seconds([&] {
+        for (auto w : words) sink += static_cast<size_t>(keywordType(w));
+    });
+
+    size_t tokens = 0;
+    double lexTime = seconds([&] {
+        Lexer lexer(src);
+        for (Token t = lexer.nextToken(); t.type != TokenType::Eof; t = lexer.nextToken())
+            tokens++;
+    });
+
+    double mb = static_cast<double>(src.size()) / (1024.0 * 1024.0);
+    std::cout << "words classified:   " << words.size() << "\n";
+    std::cout << "unordered_map:      " << words.size() / mapTime / 1e6 << " M words/s\n";
+    std::cout << "keyword switch:     " << words.size() / switchTime / 1e6 << " M words/s\n";
+    std::cout << "lexer:              " << tokens / lexTime / 1e6 << " M tokens/s, "
+              << mb / lexTime << " MB/s\n";
+    std::cout << "(checksum " << sink << ")\n";
+    return 0;
+}
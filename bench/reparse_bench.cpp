@@ -0,0 +1,52 @@
+#include "incremental_parser.hpp"
+#include "parallel_parser.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static std::string generateSource(size_t functions) {
+    std::string src;
+    for (size_t i = 0; i < functions; i++) {
+        std::string n = std::to_string(i);
+        src += "fn f" + n + "(a: Int, b: Int) -> Int {\n";
+        src += "    let x: Int = a * 10 + b;\n";
+        src += "    if x > 100 { return f" + n + "(x - 1, b); } else { return x; }\n";
+        src += "}\n";
+    }
+    return src;
+}
+
+template <typename F>
+static double seconds(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t functions = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t edits = argc > 2 ? std::stoul(argv[2]) : 1000;
+    std::string src = generateSource(functions);
+
+    std::vector<Diagnostic> diagnostics;
+    std::unique_ptr<Program> program;
+    double fullTime = seconds([&] { program = parseParallel(src, 1, diagnostics); });
+
+    size_t target = src.find("* 10", src.size() / 2) + 2;
+    double editTime = 0;
+    for (size_t i = 0; i < edits; i++) {
+        src.insert(target, "1");
+        diagnostics.clear();
+        editTime += seconds([&] { program = reparse(std::move(program), {target, 0, 1}, src, diagnostics); });
+        src.erase(target, 1);
+        diagnostics.clear();
+        editTime += seconds([&] { program = reparse(std::move(program), {target, 1, 0}, src, diagnostics); });
+    }
+
+    std::cout << "source bytes:       " << src.size() << "\n";
+    std::cout << "full parse:         " << fullTime * 1e3 << " ms\n";
+    std::cout << "reparse per edit:   " << editTime / (2.0 * edits) * 1e6 << " us\n";
+    std::cout << "functions:          " << program->functions.size() << ", arenas " << program->arenas.size() << "\n";
+    return diagnostics.empty() ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+# Writes OUTPUT with a digest of the contents of INPUTS, so the parse cache
+# stops serving entries as soon as any front-end source changes.
+set(digest "")
+foreach(input IN LISTS INPUTS)
+    file(SHA256 "${input}" hash)
+    string(APPEND digest "${hash}")
+endforeach()
+string(SHA256 digest "${digest}")
+string(SUBSTRING "${digest}" 0 16 digest)
+file(WRITE "${OUTPUT}" "#pragma once\n#define ESHARP_PARSER_REVISION \"${digest}\"\n")
@@ -1,55 +1,43 @@
 #include "error.hpp"
 #include <sstream>
 
-static std::string expandTabs(const std::string& line, int tabSize = 4) {
+// Tab stops follow the columns of the original line, which starts at col.
+static std::string expandTabs(std::string_view line, int col) {
     std::string result;
+    size_t shift = static_cast<size_t>(col - 1);
     for (char c : line) {
         if (c == '\t')
-            result.append(tabSize, ' ');
+            result.append(SourceManager::tabSize - (shift + result.size()) % SourceManager::tabSize, ' ');
         else
             result.push_back(c);
     }
     return result;
 }
 
-static int visualColumn(const std::string& line, int col, int tabSize = 4) {
-    int visualCol = 0;
-    for (int i = 0; i < col - 1 && i < (int)line.size(); i++) {
-        if (line[i] == '\t') {
-            visualCol += tabSize - (visualCol % tabSize);
-        } else {
-            visualCol++;
-        }
+static const char* stageName(DiagnosticStage stage) {
+    switch (stage) {
+        case DiagnosticStage::Lexer: return "Lexer";
+        case DiagnosticStage::Parser: return "Parse";
+        case DiagnosticStage::Resolver: return "Name";
+        case DiagnosticStage::Types: return "Type";
+        case DiagnosticStage::Lint: return "Lint";
     }
-    return visualCol;
+    return "Unknown";
 }
 
-LexerError::LexerError(const std::string& msg, int line, int col, const std::string& sourceLine)
-    : message(msg), line(line), col(col), sourceLine(sourceLine) {
-    formattedMessage = formatMessage();
-}
-
-const char* LexerError::what() const noexcept {
-    return formattedMessage.c_str();
-}
-
-int LexerError::getLine() const {
-    return line;
-}
-
-int LexerError::getCol() const {
-    return col;
-}
-
-std::string LexerError::formatMessage() const {
+std::string formatDiagnostic(const Diagnostic& diag, const SourceManager& sources) {
+    SourceLocation loc = sources.location(diag.offset);
     std::ostringstream oss;
-    oss << "Lexer error at line " << line << ", col " << col << ": " << message << "\n";
-
-    if (!sourceLine.empty()) {
-        std::string displayLine = expandTabs(sourceLine);
-        int caretPos = visualColumn(sourceLine, col);
-        oss << displayLine << "\n";
-        oss << std::string(caretPos, ' ') << "^";
+    oss << stageName(diag.stage) << (isWarning(diag.stage) ? " warning" : " error") << " at line " << loc.line << ", col " << loc.col
+        << ": " << diag.message << "\n";
+
+    // A line whose start is no longer available is shown cut, after "...".
+    int lineCol = sources.lineColumn(diag.offset);
+    std::string line = expandTabs(sources.lineText(diag.offset), lineCol);
+    if (!line.empty()) {
+        std::string cut = lineCol > 1 ? "..." : "";
+        oss << cut << line << "\n";
+        oss << std::string(cut.size() + loc.col - lineCol, ' ') << "^";
     }
     return oss.str();
 }
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+class Arena {
+public:
+    static constexpr size_t defaultSlabSize = 64 * 1024;
+
+    explicit Arena(size_t slabSize = defaultSlabSize);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) noexcept = default;
+    Arena& operator=(Arena&&) noexcept = default;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t adjust = (align - reinterpret_cast<uintptr_t>(cur) % align) % align;
+        if (adjust + size > static_cast<size_t>(end - cur)) return allocateSlow(size, align);
+        char* p = cur + adjust;
+        cur = p + size;
+        used += size;
+        return p;
+    }
+
+    char* allocateChars(size_t size) { return static_cast<char*>(allocate(size, 1)); }
+    std::string_view copy(std::string_view s);
+
+    size_t bytesUsed() const { return used; }
+    size_t bytesReserved() const { return reserved; }
+    size_t slabCount() const { return slabs.size(); }
+
+private:
+    std::vector<std::unique_ptr<char[]>> slabs;
+    char* cur = nullptr;
+    char* end = nullptr;
+    size_t slabSize;
+    size_t used = 0;
+    size_t reserved = 0;
+
+    void* allocateSlow(size_t size, size_t align);
+};
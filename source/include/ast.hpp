@@ -1,9 +1,16 @@
 #pragma once
+#include "arena.hpp"
+#include "error.hpp"
+#include "symbol_table.hpp"
+#include <cstdint>
+#include <new>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include <memory>
 
-enum class VarType {
+enum class VarType : uint8_t {
     Int,
     Float,
     String,
@@ -12,7 +19,7 @@ enum class VarType {
     Void,
 };
 
-inline std::string toString(VarType t) {
+constexpr const char* toString(VarType t) {
     switch (t) {
         case VarType::Int: return "Int";
         case VarType::Float: return "Float";
@@ -20,120 +27,252 @@ inline std::string toString(VarType t) {
         case VarType::Char: return "Char";
         case VarType::Bool: return "Bool";
         case VarType::Void: return "Void";
-        default: return "Unknown";
     }
+    return "Unknown";
 }
 
+enum class BinaryOp : uint8_t {
+    Assign, AddAssign, SubAssign, MulAssign, DivAssign,
+    Eq, Neq, Less, Greater, Leq, Geq,
+    Add, Sub, Mul, Div,
+};
+
+enum class UnaryOp : uint8_t {
+    Neg, Not,
+};
+
+constexpr const char* toString(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::Assign: return "=";
+        case BinaryOp::AddAssign: return "+=";
+        case BinaryOp::SubAssign: return "-=";
+        case BinaryOp::MulAssign: return "*=";
+        case BinaryOp::DivAssign: return "/=";
+        case BinaryOp::Eq: return "==";
+        case BinaryOp::Neq: return "!=";
+        case BinaryOp::Less: return "<";
+        case BinaryOp::Greater: return ">";
+        case BinaryOp::Leq: return "<=";
+        case BinaryOp::Geq: return ">=";
+        case BinaryOp::Add: return "+";
+        case BinaryOp::Sub: return "-";
+        case BinaryOp::Mul: return "*";
+        case BinaryOp::Div: return "/";
+    }
+    return "?";
+}
+
+constexpr const char* toString(UnaryOp op) {
+    return op == UnaryOp::Neg ? "-" : "!";
+}
+
+template <typename T>
+struct ArenaList {
+    T* items = nullptr;
+    uint32_t count = 0;
+
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t i) const { return items[i]; }
+};
+
+enum class NodeKind : uint8_t {
+    Int, Double, String, Char, Bool, Void, Var, Unary, Binary, Call,
+    Return, If, Let, Block, Function, Program,
+};
+
+constexpr uint32_t unbound = UINT32_MAX;
+
+// Offsets are relative to the enclosing function. A function's own start
+// is kept in Function::start, relative to its ProgramItem when the program
+// has items, so that reparsing never has to touch the functions after an
+// edit; use Program::functionOffset() for the absolute position.
 struct ASTNode {
-    virtual ~ASTNode() = default;
-    virtual void dump(int indent = 0) const = 0;
+    const NodeKind kind;
+    uint32_t offset = 0;
+
+    explicit ASTNode(NodeKind k) : kind(k) {}
+
+protected:
+    ~ASTNode() = default;
 };
 
-using ASTPtr = std::unique_ptr<ASTNode>;
+using ASTPtr = ASTNode*;
+using ASTList = ArenaList<ASTPtr>;
+
+class AstArena {
+public:
+    static constexpr size_t slabSize = 1 << 20;
 
-struct Expr : ASTNode {};
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "arena nodes are never destroyed individually");
+        nodes++;
+        return new (arena.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    ArenaList<T> list(const std::vector<T>& items) {
+        ArenaList<T> out;
+        if (items.empty()) return out;
+        out.items = static_cast<T*>(arena.allocate(sizeof(T) * items.size(), alignof(T)));
+        out.count = static_cast<uint32_t>(items.size());
+        std::uninitialized_copy(items.begin(), items.end(), out.items);
+        return out;
+    }
+
+    std::string_view copy(std::string_view s) { return arena.copy(s); }
+
+    size_t nodeCount() const { return nodes; }
+    size_t bytesUsed() const { return arena.bytesUsed(); }
+    size_t bytesReserved() const { return arena.bytesReserved(); }
+
+private:
+    Arena arena{slabSize};
+    size_t nodes = 0;
+};
+
+struct Expr : ASTNode {
+    using ASTNode::ASTNode;
+    VarType type = VarType::Void;
+};
 
 struct IntExpr : Expr {
     int64_t value;
     explicit IntExpr(int64_t v);
-    void dump(int indent = 0) const override;
 };
 
 struct DoubleExpr : Expr {
     double value;
     explicit DoubleExpr(double v);
-    void dump(int indent = 0) const override;
 };
 
 struct StringExpr : Expr {
-    std::string value;
-    explicit StringExpr(const std::string& v);
-    void dump(int indent = 0) const override;
+    std::string_view value;
+    explicit StringExpr(std::string_view v);
 };
 
 struct CharExpr : Expr {
     char value;
     explicit CharExpr(char v);
-    void dump(int indent = 0) const override;
 };
 
 struct BoolExpr : Expr {
     bool value;
     explicit BoolExpr(bool v);
-    void dump(int indent = 0) const override;
 };
 
 struct VoidExpr : Expr {
     VoidExpr();
-    void dump(int indent = 0) const override;
 };
 
 struct VarExpr : Expr {
-    std::string name;
-    explicit VarExpr(const std::string& n);
-    void dump(int indent = 0) const override;
+    Symbol name;
+    uint32_t slot = unbound;
+    explicit VarExpr(Symbol n);
+};
+
+struct UnaryExpr : Expr {
+    UnaryOp op;
+    ASTPtr operand = nullptr;
+    UnaryExpr(UnaryOp o, ASTPtr e);
 };
 
 struct BinaryExpr : Expr {
-    std::string op;
+    BinaryOp op;
     ASTPtr left = nullptr;
     ASTPtr right = nullptr;
-    BinaryExpr(const std::string& o, ASTPtr l, ASTPtr r);
-    void dump(int indent = 0) const override;
+    BinaryExpr(BinaryOp o, ASTPtr l, ASTPtr r);
 };
 
 struct CallExpr : Expr {
-    std::string callee;
-    std::vector<ASTPtr> args;
-    CallExpr(const std::string& c, std::vector<ASTPtr> a);
-    void dump(int indent = 0) const override;
+    Symbol callee;
+    uint32_t target = unbound;
+    ASTList args;
+    CallExpr(Symbol c, ASTList a);
 };
 
-struct Stmt : ASTNode {};
+struct Stmt : ASTNode {
+    using ASTNode::ASTNode;
+};
 
 struct ReturnStmt : Stmt {
     ASTPtr value;
     explicit ReturnStmt(ASTPtr v);
-    void dump(int indent = 0) const override;
 };
 
 struct IfStmt : Stmt {
     ASTPtr cond = nullptr;
-    std::vector<ASTPtr> thenBranch;
-    std::vector<ASTPtr> elseBranch;
-    IfStmt(ASTPtr condition,
-           std::vector<ASTPtr> thenB,
-           std::vector<ASTPtr> elseB = {});
-    void dump(int indent = 0) const override;
+    ASTList thenBranch;
+    ASTList elseBranch;
+    IfStmt(ASTPtr condition, ASTList thenB, ASTList elseB = {});
 };
 
 struct LetDecl : Stmt {
-    std::string name;
+    Symbol name;
     VarType type;
+    uint32_t slot = unbound;
     ASTPtr init = nullptr;
-    LetDecl(const std::string& n, VarType t, ASTPtr i);
-    void dump(int indent = 0) const override;
+    LetDecl(Symbol n, VarType t, ASTPtr i);
 };
 
 struct BlockStmt : Stmt {
-    std::vector<ASTPtr> statements;
-    explicit BlockStmt(std::vector<ASTPtr> stmts);
-    void dump(int indent = 0) const override;
+    ASTList statements;
+    explicit BlockStmt(ASTList stmts);
+};
+
+struct Param {
+    Symbol name;
+    VarType type;
+    uint32_t offset = 0;
 };
 
 struct Function : Stmt {
-    std::string name;
+    Symbol name;
     VarType returnType;
-    std::vector<std::pair<std::string, VarType>> params;
-    std::unique_ptr<BlockStmt> body;
-    Function(const std::string& n,
-             VarType rt,
-             std::vector<std::pair<std::string, VarType>> p,
-             std::unique_ptr<BlockStmt> b);
-    void dump(int indent = 0) const override;
+    ArenaList<Param> params;
+    BlockStmt* body;
+    size_t start = 0;
+    uint32_t frameSize = 0;
+    Function(Symbol n, VarType rt, ArenaList<Param> p, BlockStmt* b);
+};
+
+struct ProgramItem {
+    SourceSpan span;
+    uint32_t firstFunction = 0;
+    uint32_t functionCount = 0;
+    uint32_t firstDiagnostic = 0;
+    uint32_t diagnosticCount = 0;
+    size_t bytes = 0;
+};
+
+struct ItemShift {
+    size_t from = 0;
+    size_t offset = 0;
+    uint32_t functions = 0;
+    uint32_t diagnostics = 0;
 };
 
 struct Program : ASTNode {
-    std::vector<std::unique_ptr<Function>> functions;
-    void dump(int indent = 0) const override;
-};
\ No newline at end of file
+    Program();
+    std::vector<std::unique_ptr<AstArena>> arenas;
+    std::vector<Function*> functions;
+    std::vector<ProgramItem> items;
+    std::vector<Diagnostic> diagnostics;
+    ItemShift pendingShift;
+    size_t discardedBytes = 0;
+
+    AstArena& arena() { return *arenas.front(); }
+    void adopt(std::unique_ptr<AstArena> other);
+    ProgramItem item(size_t i) const;
+    size_t functionOffset(size_t i) const;
+    void settleItems(size_t end = SIZE_MAX);
+
+    size_t nodeCount() const;
+    size_t bytesUsed() const;
+    size_t bytesReserved() const;
+
+};
@@ -0,0 +1,175 @@
+#pragma once
+#include "ast.hpp"
+#include "output_sink.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+enum class DumpFormat : uint8_t {
+    Text,
+    Json,
+    Sexpr,
+};
+
+bool parseDumpFormat(std::string_view name, DumpFormat& format);
+
+struct NodeHead {
+    NodeKind kind = NodeKind::Void;
+    uint8_t op = 0;
+    VarType type = VarType::Void;
+    std::string_view text;
+    int64_t intValue = 0;
+    double doubleValue = 0;
+    uint32_t paramCount = 0;
+};
+
+template <typename Ref, typename List>
+struct DumpField {
+    const char* key = nullptr;
+    Ref child{};
+    List items{};
+    uint32_t count = 0;
+    bool isList = false;
+    const char* label = nullptr;
+    bool wrap = false;
+
+    static DumpField node(const char* key, Ref child) {
+        DumpField f;
+        f.key = key;
+        f.child = child;
+        return f;
+    }
+
+    static DumpField list(const char* key, List items, uint32_t count, const char* label = nullptr, bool wrap = false) {
+        DumpField f;
+        f.key = key;
+        f.items = items;
+        f.count = count;
+        f.isList = true;
+        f.label = label;
+        f.wrap = wrap;
+        return f;
+    }
+};
+
+class DumpWriter {
+public:
+    DumpWriter(OutputSink& sink, DumpFormat mode) : out(sink), format(mode) {}
+
+    void head(const NodeHead& head, int indent, bool first, bool root);
+    void param(std::string_view name, VarType type, int indent, uint32_t index);
+    void endParams(const NodeHead& head);
+    void nullChild(bool first, bool root);
+    void field(const char* key);
+    void openList(const char* key, const char* label, bool wrap, int indent);
+    void closeList(bool wrap);
+    void close();
+    void finish();
+
+    static bool isLeaf(NodeKind kind) { return kind <= NodeKind::Var; }
+
+private:
+    OutputSink& out;
+    DumpFormat format;
+
+    void quoted(std::string_view s);
+    void jsonString(std::string_view s);
+    void textHead(const NodeHead& head);
+    void jsonHead(const NodeHead& head);
+    void sexprHead(const NodeHead& head);
+};
+
+template <typename Tree>
+void dumpSubtree(const Tree& tree, typename Tree::Ref root, DumpWriter& out, int indent, bool first, bool isRoot) {
+    using Ref = typename Tree::Ref;
+    using Field = typename Tree::Field;
+
+    enum class Op : uint8_t { Node, Field, OpenList, CloseList, Close };
+    struct Step {
+        Op op;
+        bool first;
+        bool root;
+        bool wrap;
+        int indent;
+        Ref node;
+        const char* key;
+        const char* label;
+    };
+
+    std::vector<Step> stack{{Op::Node, first, isRoot, false, indent, root, nullptr, nullptr}};
+    Field fields[3];
+    while (!stack.empty()) {
+        Step step = stack.back();
+        stack.pop_back();
+        switch (step.op) {
+            case Op::Field:
+                out.field(step.key);
+                continue;
+            case Op::OpenList:
+                out.openList(step.key, step.label, step.wrap, step.indent);
+                continue;
+            case Op::CloseList:
+                out.closeList(step.wrap);
+                continue;
+            case Op::Close:
+                out.close();
+                continue;
+            case Op::Node:
+                break;
+        }
+
+        if (Tree::isNull(step.node)) {
+            out.nullChild(step.first, step.root);
+            continue;
+        }
+        NodeHead head;
+        int fieldCount = tree.describe(step.node, head, fields);
+        out.head(head, step.indent, step.first, step.root);
+        if (head.kind == NodeKind::Function) {
+            for (uint32_t i = 0; i < head.paramCount; i++) {
+                std::string_view name;
+                VarType type;
+                tree.param(step.node, i, name, type);
+                out.param(name, type, step.indent + 2, i);
+            }
+            out.endParams(head);
+        }
+        if (DumpWriter::isLeaf(head.kind)) continue;
+
+        int inner = step.indent + 2;
+        stack.push_back({Op::Close, false, false, false, step.indent, Ref{}, nullptr, nullptr});
+        for (int f = fieldCount; f-- > 0;) {
+            const Field& field = fields[f];
+            if (!field.isList) {
+                stack.push_back({Op::Node, true, false, false, inner, field.child, nullptr, nullptr});
+                stack.push_back({Op::Field, false, false, false, inner, Ref{}, field.key, nullptr});
+                continue;
+            }
+            stack.push_back({Op::CloseList, false, false, field.wrap, inner, Ref{}, nullptr, nullptr});
+            for (uint32_t i = field.count; i-- > 0;)
+                stack.push_back({Op::Node, i == 0, false, false, inner, Tree::item(field.items, i), nullptr, nullptr});
+            stack.push_back({Op::OpenList, false, false, field.wrap, step.indent, Ref{}, field.key, field.label});
+        }
+    }
+}
+
+template <typename Tree>
+void dumpWith(const Tree& tree, typename Tree::Ref root, OutputSink& sink, DumpFormat format, int indent = 0) {
+    DumpWriter out(sink, format);
+    dumpSubtree(tree, root, out, indent, true, true);
+    out.finish();
+}
+
+void dumpTree(const ASTNode& root, OutputSink& sink, DumpFormat format = DumpFormat::Text, int indent = 0);
+
+class ProgramDumpStream {
+public:
+    ProgramDumpStream(OutputSink& sink, DumpFormat format);
+
+    void add(const Function& fn);
+    void finish();
+
+private:
+    DumpWriter out;
+    uint32_t count = 0;
+};
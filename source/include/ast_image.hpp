@@ -0,0 +1,89 @@
+#pragma once
+#include "flat_ast.hpp"
+#include "source_file.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class AstImage {
+public:
+    using Index = FlatAst::Index;
+    static constexpr Index none = FlatAst::none;
+    static constexpr uint32_t formatVersion = 1;
+
+    struct Node {
+        NodeKind kind;
+        uint8_t reserved[3];
+        Index a, b, c;
+    };
+
+    struct String {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct FunctionEntry {
+        Index name;
+        Index node;
+    };
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t byteOrder;
+        Index root;
+        uint32_t nodeCount;
+        uint32_t listWords;
+        uint32_t literalCount;
+        uint32_t stringCount;
+        uint32_t functionCount;
+        uint32_t stringBytes;
+        uint64_t nodes;
+        uint64_t lists;
+        uint64_t literals;
+        uint64_t strings;
+        uint64_t stringData;
+        uint64_t functions;
+        uint64_t size;
+    };
+
+    static std::string encode(const FlatAst& ast);
+    static bool isImage(std::string_view bytes);
+
+    bool open(const std::string& path);
+    bool attach(std::string_view bytes);
+    bool verify() const;
+
+    void dump(OutputSink& out, DumpFormat format = DumpFormat::Text) const;
+
+    size_t nodeCount() const { return header->nodeCount; }
+    Index root() const { return header->root; }
+
+    NodeKind kind(Index n) const { return nodes[n].kind; }
+    Index a(Index n) const { return nodes[n].a; }
+    Index b(Index n) const { return nodes[n].b; }
+    Index c(Index n) const { return nodes[n].c; }
+
+    uint32_t listSize(Index list) const { return lists[list]; }
+    const Index* listItems(Index list) const { return lists + list + 1; }
+    std::string_view name(Index id) const { return {stringData + strings[id].offset, strings[id].length}; }
+    uint64_t literal(Index id) const { return literals[id]; }
+
+    size_t functionCount() const { return header->functionCount; }
+    Index findFunction(std::string_view name) const;
+
+private:
+    SourceFile file;
+    const Header* header = nullptr;
+    const Node* nodes = nullptr;
+    const Index* lists = nullptr;
+    const uint64_t* literals = nullptr;
+    const String* strings = nullptr;
+    const char* stringData = nullptr;
+    const FunctionEntry* functions = nullptr;
+
+    bool validList(Index list) const;
+    bool validChild(Index child, Index parent) const;
+    bool requiredChild(Index child, Index parent) const;
+    bool validNodeList(Index list, Index parent) const;
+};
@@ -0,0 +1,11 @@
+#pragma once
+#include "ast.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+constexpr uint32_t astFormatVersion = 2;
+
+std::string serializeProgram(const Program& program);
+std::unique_ptr<Program> deserializeProgram(std::string_view bytes);
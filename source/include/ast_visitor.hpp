@@ -0,0 +1,148 @@
+#pragma once
+#include "ast.hpp"
+#include <cstdint>
+#include <vector>
+
+enum class VisitAction : uint8_t {
+    Continue,
+    SkipChildren,
+    Stop,
+};
+
+// visit() dispatches one node on its kind. traverse() walks a subtree in
+// source order; leave() also runs when enter() returned SkipChildren, and
+// visitNull() runs for each absent optional child.
+template <typename Derived, typename R = void>
+class AstVisitor {
+public:
+    R visit(const ASTNode& node) {
+        Derived& self = derived();
+        switch (node.kind) {
+            case NodeKind::Int: return self.visitInt(static_cast<const IntExpr&>(node));
+            case NodeKind::Double: return self.visitDouble(static_cast<const DoubleExpr&>(node));
+            case NodeKind::String: return self.visitString(static_cast<const StringExpr&>(node));
+            case NodeKind::Char: return self.visitChar(static_cast<const CharExpr&>(node));
+            case NodeKind::Bool: return self.visitBool(static_cast<const BoolExpr&>(node));
+            case NodeKind::Void: return self.visitVoid(static_cast<const VoidExpr&>(node));
+            case NodeKind::Var: return self.visitVar(static_cast<const VarExpr&>(node));
+            case NodeKind::Unary: return self.visitUnary(static_cast<const UnaryExpr&>(node));
+            case NodeKind::Binary: return self.visitBinary(static_cast<const BinaryExpr&>(node));
+            case NodeKind::Call: return self.visitCall(static_cast<const CallExpr&>(node));
+            case NodeKind::Return: return self.visitReturn(static_cast<const ReturnStmt&>(node));
+            case NodeKind::If: return self.visitIf(static_cast<const IfStmt&>(node));
+            case NodeKind::Let: return self.visitLet(static_cast<const LetDecl&>(node));
+            case NodeKind::Block: return self.visitBlock(static_cast<const BlockStmt&>(node));
+            case NodeKind::Function: return self.visitFunction(static_cast<const Function&>(node));
+            case NodeKind::Program: return self.visitProgram(static_cast<const Program&>(node));
+        }
+        return R();
+    }
+
+    bool traverse(const ASTNode& root) {
+        Derived& self = derived();
+        stack.clear();
+        stack.push_back({&root, false});
+        while (!stack.empty()) {
+            Frame frame = stack.back();
+            stack.pop_back();
+            if (!frame.node) {
+                self.visitNull();
+                continue;
+            }
+            if (frame.leaving) {
+                if (self.leave(*frame.node) == VisitAction::Stop) return false;
+                continue;
+            }
+            VisitAction action = self.enter(*frame.node);
+            if (action == VisitAction::Stop) return false;
+            stack.push_back({frame.node, true});
+            if (action == VisitAction::Continue) pushChildren(*frame.node);
+        }
+        return true;
+    }
+
+    VisitAction enter(const ASTNode&) { return VisitAction::Continue; }
+    VisitAction leave(const ASTNode&) { return VisitAction::Continue; }
+    void visitNull() {}
+
+    R visitInt(const IntExpr& n) { return derived().visitExpr(n); }
+    R visitDouble(const DoubleExpr& n) { return derived().visitExpr(n); }
+    R visitString(const StringExpr& n) { return derived().visitExpr(n); }
+    R visitChar(const CharExpr& n) { return derived().visitExpr(n); }
+    R visitBool(const BoolExpr& n) { return derived().visitExpr(n); }
+    R visitVoid(const VoidExpr& n) { return derived().visitExpr(n); }
+    R visitVar(const VarExpr& n) { return derived().visitExpr(n); }
+    R visitUnary(const UnaryExpr& n) { return derived().visitExpr(n); }
+    R visitBinary(const BinaryExpr& n) { return derived().visitExpr(n); }
+    R visitCall(const CallExpr& n) { return derived().visitExpr(n); }
+    R visitReturn(const ReturnStmt& n) { return derived().visitStmt(n); }
+    R visitIf(const IfStmt& n) { return derived().visitStmt(n); }
+    R visitLet(const LetDecl& n) { return derived().visitStmt(n); }
+    R visitBlock(const BlockStmt& n) { return derived().visitStmt(n); }
+    R visitFunction(const Function& n) { return derived().visitStmt(n); }
+    R visitProgram(const Program& n) { return derived().visitNode(n); }
+
+    R visitExpr(const Expr& n) { return derived().visitNode(n); }
+    R visitStmt(const Stmt& n) { return derived().visitNode(n); }
+    R visitNode(const ASTNode&) { return R(); }
+
+protected:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+
+private:
+    struct Frame {
+        const ASTNode* node;
+        bool leaving;
+    };
+
+    std::vector<Frame> stack;
+
+    void push(const ASTNode* node) { stack.push_back({node, false}); }
+
+    void pushList(const ASTList& list) {
+        for (size_t i = list.size(); i-- > 0;) push(list[i]);
+    }
+
+    void pushChildren(const ASTNode& node) {
+        switch (node.kind) {
+            case NodeKind::Unary:
+                push(static_cast<const UnaryExpr&>(node).operand);
+                break;
+            case NodeKind::Binary: {
+                auto& n = static_cast<const BinaryExpr&>(node);
+                push(n.right);
+                push(n.left);
+                break;
+            }
+            case NodeKind::Call:
+                pushList(static_cast<const CallExpr&>(node).args);
+                break;
+            case NodeKind::Return:
+                push(static_cast<const ReturnStmt&>(node).value);
+                break;
+            case NodeKind::If: {
+                auto& n = static_cast<const IfStmt&>(node);
+                pushList(n.elseBranch);
+                pushList(n.thenBranch);
+                push(n.cond);
+                break;
+            }
+            case NodeKind::Let:
+                push(static_cast<const LetDecl&>(node).init);
+                break;
+            case NodeKind::Block:
+                pushList(static_cast<const BlockStmt&>(node).statements);
+                break;
+            case NodeKind::Function:
+                push(static_cast<const Function&>(node).body);
+                break;
+            case NodeKind::Program: {
+                auto& n = static_cast<const Program&>(node);
+                for (size_t i = n.functions.size(); i-- > 0;) push(n.functions[i]);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+enum CharClass : uint8_t {
+    CC_IdentStart = 1 << 0,
+    CC_IdentContinue = 1 << 1,
+    CC_Digit = 1 << 2,
+    CC_Space = 1 << 3,
+    CC_OperatorStart = 1 << 4,
+};
+
+constexpr std::array<uint8_t, 256> makeCharClassTable() {
+    std::array<uint8_t, 256> table{};
+    for (int c = 'a'; c <= 'z'; c++) table[c] = CC_IdentStart | CC_IdentContinue;
+    for (int c = 'A'; c <= 'Z'; c++) table[c] = CC_IdentStart | CC_IdentContinue;
+    for (int c = '0'; c <= '9'; c++) table[c] = CC_Digit | CC_IdentContinue;
+    table['_'] = CC_IdentStart | CC_IdentContinue;
+    for (char c : {' ', '\t', '\n', '\v', '\f', '\r'})
+        table[static_cast<unsigned char>(c)] = CC_Space;
+    for (char c : {'(', ')', '{', '}', ',', ':', ';', '+', '-', '*', '/', '=', '!', '<', '>', '"', '\''})
+        table[static_cast<unsigned char>(c)] = CC_OperatorStart;
+    return table;
+}
+
+inline constexpr std::array<uint8_t, 256> charClassTable = makeCharClassTable();
+
+constexpr uint8_t charClass(char c) {
+    return charClassTable[static_cast<unsigned char>(c)];
+}
+
+constexpr bool isIdentStart(char c) { return charClass(c) & CC_IdentStart; }
+constexpr bool isIdentContinue(char c) { return charClass(c) & CC_IdentContinue; }
+constexpr bool isDigit(char c) { return charClass(c) & CC_Digit; }
+constexpr bool isSpace(char c) { return charClass(c) & CC_Space; }
+constexpr bool isOperatorStart(char c) { return charClass(c) & CC_OperatorStart; }
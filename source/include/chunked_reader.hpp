@@ -0,0 +1,47 @@
+#pragma once
+#include "item_splitter.hpp"
+#include <string>
+#include <string_view>
+
+class ChunkedReader {
+public:
+    static constexpr size_t defaultChunkSize = 1 << 16;
+
+    explicit ChunkedReader(size_t chunkSize = defaultChunkSize);
+    ~ChunkedReader();
+
+    ChunkedReader(const ChunkedReader&) = delete;
+    ChunkedReader& operator=(const ChunkedReader&) = delete;
+
+    bool open(const std::string& path);
+    bool nextItem(std::string_view& item);
+
+    // The item with up to a chunk of buffered text on either side, for
+    // diagnostics. It starts in column itemFirstColumn() of line
+    // itemFirstLine(); the item itself begins at itemBegin().
+    std::string_view itemLines() const;
+    size_t itemBegin() const { return itemStart - context; }
+    int itemFirstLine() const { return firstLine; }
+    int itemFirstColumn() const { return firstColumn; }
+    size_t itemOffset() const { return consumed + itemStart; }
+    size_t peakBufferSize() const { return peak; }
+
+private:
+    int fd = -1;
+    bool ownsFd = false;
+    bool eof = false;
+    size_t chunkSize;
+    std::string buffer;
+    size_t scanPos = 0;
+    size_t released = 0;
+    size_t itemStart = 0;
+    size_t context = 0;
+    size_t consumed = 0;
+    size_t peak = 0;
+    int firstLine = 1;
+    int firstColumn = 1;
+    ItemSplitter splitter;
+
+    void release();
+    bool fill();
+};
@@ -1,22 +1,16 @@
 #pragma once
-#include <exception>
+#include "source_manager.hpp"
+#include <cstddef>
 #include <string>
 
-class LexerError : public std::exception {
-public:
-    LexerError(const std::string& msg, int line, int col, const std::string& sourceLine = "");
+enum class DiagnosticStage { Lexer, Parser, Resolver, Types, Lint };
 
-    const char* what() const noexcept override;
+inline bool isWarning(DiagnosticStage stage) { return stage == DiagnosticStage::Lint; }
 
-    int getLine() const;
-    int getCol() const;
-
-private:
+struct Diagnostic {
+    DiagnosticStage stage;
     std::string message;
-    int line;
-    int col;
-    std::string sourceLine;
-    std::string formattedMessage;
+    size_t offset;
+};
 
-    std::string formatMessage() const;
-};
\ No newline at end of file
+std::string formatDiagnostic(const Diagnostic& diag, const SourceManager& sources);
@@ -0,0 +1,54 @@
+#pragma once
+#include "arena.hpp"
+#include "ast.hpp"
+#include "ast_dumper.hpp"
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class FlatAst {
+public:
+    using Index = uint32_t;
+    static constexpr Index none = UINT32_MAX;
+
+    static FlatAst fromTree(const Program& program);
+
+    void dump(OutputSink& out, DumpFormat format = DumpFormat::Text) const;
+
+    size_t nodeCount() const { return kinds.size(); }
+    size_t bytes() const;
+    Index root() const { return rootIndex; }
+
+    NodeKind kind(Index n) const { return kinds[n]; }
+    Index a(Index n) const { return fieldA[n]; }
+    Index b(Index n) const { return fieldB[n]; }
+    Index c(Index n) const { return fieldC[n]; }
+
+    uint32_t listSize(Index list) const { return extra[list]; }
+    const Index* listItems(Index list) const { return extra.data() + list + 1; }
+    std::string_view name(Index id) const { return names[id]; }
+    uint64_t literal(Index id) const { return literals[id]; }
+
+private:
+    std::vector<NodeKind> kinds;
+    std::vector<Index> fieldA;
+    std::vector<Index> fieldB;
+    std::vector<Index> fieldC;
+    std::vector<Index> extra;
+    std::vector<uint64_t> literals;
+    std::vector<std::string_view> names;
+    std::unordered_map<std::string_view, Index> nameIds;
+    std::unordered_map<Symbol, Index> symbolIds;
+    Arena nameStorage;
+    Index rootIndex = none;
+
+    friend class FlatAstBuilder;
+    friend class AstImage;
+
+    Index addNode(NodeKind kind, Index a = 0, Index b = 0, Index c = 0);
+    Index intern(std::string_view s);
+    Index intern(Symbol s);
+    Index addLiteral(uint64_t bits);
+    Index addList(const std::vector<Index>& items);
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include "ast_dumper.hpp"
+#include <cstdint>
+#include <cstring>
+
+template <typename View>
+struct FlatDumpView {
+    using Ref = uint32_t;
+    using Field = DumpField<Ref, const Ref*>;
+
+    const View& ast;
+
+    static bool isNull(Ref n) { return n == UINT32_MAX; }
+    static Ref item(const Ref* items, uint32_t i) { return items[i]; }
+
+    Field nodes(const char* key, Ref list, const char* label = nullptr, bool wrap = false) const {
+        return Field::list(key, ast.listItems(list), ast.listSize(list), label, wrap);
+    }
+
+    int describe(Ref n, NodeHead& head, Field* fields) const {
+        head.kind = ast.kind(n);
+        switch (head.kind) {
+            case NodeKind::Int:
+                head.intValue = static_cast<int64_t>(ast.literal(ast.a(n)));
+                return 0;
+            case NodeKind::Double: {
+                uint64_t bits = ast.literal(ast.a(n));
+                std::memcpy(&head.doubleValue, &bits, sizeof(bits));
+                return 0;
+            }
+            case NodeKind::String:
+            case NodeKind::Var:
+                head.text = ast.name(ast.a(n));
+                return 0;
+            case NodeKind::Char:
+                head.intValue = static_cast<char>(ast.a(n));
+                return 0;
+            case NodeKind::Bool:
+                head.intValue = ast.a(n) != 0;
+                return 0;
+            case NodeKind::Void:
+                return 0;
+            case NodeKind::Unary:
+                head.op = static_cast<uint8_t>(ast.a(n));
+                fields[0] = Field::node("operand", ast.b(n));
+                return 1;
+            case NodeKind::Binary:
+                head.op = static_cast<uint8_t>(ast.a(n));
+                fields[0] = Field::node("left", ast.b(n));
+                fields[1] = Field::node("right", ast.c(n));
+                return 2;
+            case NodeKind::Call:
+                head.text = ast.name(ast.a(n));
+                fields[0] = nodes("args", ast.b(n));
+                return 1;
+            case NodeKind::Return:
+                fields[0] = Field::node("value", ast.a(n));
+                return 1;
+            case NodeKind::If:
+                fields[0] = Field::node("cond", ast.a(n));
+                fields[1] = nodes("then", ast.b(n), "Then:", true);
+                fields[2] = nodes("else", ast.c(n), ast.listSize(ast.c(n)) ? "Else:" : nullptr, true);
+                return 3;
+            case NodeKind::Let:
+                head.text = ast.name(ast.a(n));
+                head.type = static_cast<VarType>(ast.c(n));
+                fields[0] = Field::node("init", ast.b(n));
+                return 1;
+            case NodeKind::Block:
+                fields[0] = nodes("statements", ast.a(n));
+                return 1;
+            case NodeKind::Function:
+                head.text = ast.name(ast.a(n));
+                head.type = static_cast<VarType>(ast.listItems(ast.b(n))[0]);
+                head.paramCount = (ast.listSize(ast.b(n)) - 1) / 2;
+                fields[0] = Field::node("body", ast.c(n));
+                return 1;
+            case NodeKind::Program:
+                fields[0] = nodes("functions", ast.a(n));
+                return 1;
+        }
+        return 0;
+    }
+
+    void param(Ref n, uint32_t i, std::string_view& name, VarType& type) const {
+        const Ref* sig = ast.listItems(ast.b(n));
+        name = ast.name(sig[1 + 2 * i]);
+        type = static_cast<VarType>(sig[2 + 2 * i]);
+    }
+};
+
+template <typename View>
+void dumpFlat(const View& ast, uint32_t root, OutputSink& sink, DumpFormat format = DumpFormat::Text, int indent = 0) {
+    dumpWith(FlatDumpView<View>{ast}, root, sink, format, indent);
+}
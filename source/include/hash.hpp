@@ -0,0 +1,5 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+uint64_t hash64(std::string_view data, uint64_t seed = 0);
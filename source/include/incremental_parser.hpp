@@ -0,0 +1,17 @@
+#pragma once
+#include "ast.hpp"
+#include "error.hpp"
+#include "parser.hpp"
+#include <memory>
+#include <string_view>
+#include <vector>
+
+struct TextEdit {
+    size_t offset;
+    size_t removed;
+    size_t inserted;
+};
+
+std::unique_ptr<Program> reparse(std::unique_ptr<Program> old, const TextEdit& edit,
+                                 std::string_view newText, std::vector<Diagnostic>& diagnostics,
+                                 unsigned maxNesting = Parser::defaultMaxNesting);
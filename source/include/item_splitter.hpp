@@ -0,0 +1,20 @@
+#pragma once
+#include "source_manager.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class ItemSplitter {
+public:
+    bool next(std::string_view text, size_t& pos, bool atEof);
+    void reset();
+
+private:
+    enum class State : uint8_t { Code, LineComment, BlockComment, String, Char };
+
+    State state = State::Code;
+    int depth = 0;
+    bool escape = false;
+};
+
+std::vector<SourceSpan> splitTopLevelItems(std::string_view text);
@@ -0,0 +1,55 @@
+#pragma once
+#include "lexer.hpp"
+#include <string_view>
+
+constexpr TokenType keywordType(std::string_view word) {
+    switch (word.size()) {
+        case 2:
+            if (word == "fn") return TokenType::Fn;
+            if (word == "if") return TokenType::If;
+            break;
+        case 3:
+            if (word[0] == 'l') return word == "let" ? TokenType::Let : TokenType::Identifier;
+            if (word[0] == 'I') return word == "Int" ? TokenType::IntType : TokenType::Identifier;
+            break;
+        case 4:
+            switch (word[0]) {
+                case 'e': return word == "else" ? TokenType::Else : TokenType::Identifier;
+                case 't': return word == "true" ? TokenType::Bool : TokenType::Identifier;
+                case 'C': return word == "Char" ? TokenType::CharType : TokenType::Identifier;
+                case 'B': return word == "Bool" ? TokenType::BoolType : TokenType::Identifier;
+                case 'V': return word == "Void" ? TokenType::VoidType : TokenType::Identifier;
+            }
+            break;
+        case 5:
+            switch (word[0]) {
+                case 'p': return word == "print" ? TokenType::Print : TokenType::Identifier;
+                case 'F': return word == "Float" ? TokenType::FloatType : TokenType::Identifier;
+                case 'f': return word == "false" ? TokenType::Bool : TokenType::Identifier;
+            }
+            break;
+        case 6:
+            if (word[0] == 'r') return word == "return" ? TokenType::Return : TokenType::Identifier;
+            if (word[0] == 'S') return word == "String" ? TokenType::StringType : TokenType::Identifier;
+            break;
+    }
+    return TokenType::Identifier;
+}
+
+static_assert(keywordType("fn") == TokenType::Fn);
+static_assert(keywordType("let") == TokenType::Let);
+static_assert(keywordType("if") == TokenType::If);
+static_assert(keywordType("else") == TokenType::Else);
+static_assert(keywordType("return") == TokenType::Return);
+static_assert(keywordType("print") == TokenType::Print);
+static_assert(keywordType("Int") == TokenType::IntType);
+static_assert(keywordType("Float") == TokenType::FloatType);
+static_assert(keywordType("String") == TokenType::StringType);
+static_assert(keywordType("Char") == TokenType::CharType);
+static_assert(keywordType("Bool") == TokenType::BoolType);
+static_assert(keywordType("Void") == TokenType::VoidType);
+static_assert(keywordType("true") == TokenType::Bool);
+static_assert(keywordType("false") == TokenType::Bool);
+static_assert(keywordType("fnx") == TokenType::Identifier);
+static_assert(keywordType("lex") == TokenType::Identifier);
+static_assert(keywordType("") == TokenType::Identifier);
@@ -1,10 +1,15 @@
 #pragma once
-#include "error.hpp"
+#include "arena.hpp"
+#include "source_manager.hpp"
+#include "symbol_table.hpp"
+#include <array>
+#include <memory>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <stdexcept>
-#include <unordered_map>
 
-enum class TokenType {
+enum class TokenType : uint8_t {
     Fn, Let, Return, If, Else, Print,
     Identifier, Integer, Float, String, Char, Bool,
     IntType, FloatType, StringType, CharType, BoolType, VoidType,
@@ -13,41 +18,69 @@ enum class TokenType {
     PlusAssign, MinusAssign, StarAssign, SlashAssign,
     Less, Greater,
     LParen, RParen, LBrace, RBrace, Semi, Comma,
-    Eof
+    Error, Eof
 };
 
 struct Token {
+    Token() : Token(TokenType::Eof, {}, 0) {}
+    Token(TokenType t, std::string_view lex, size_t off)
+        : type(t), lexeme(lex), offset(off), intValue(0) {}
+
     TokenType type;
-    std::string lexeme;
-    int line;
-    int col;
+    std::string_view lexeme;
+    size_t offset;
+    union {
+        int64_t intValue;
+        double floatValue;
+        char charValue;
+        bool boolValue;
+        const char* errorMessage;
+        Symbol symbol;
+    };
+    std::string_view stringValue;
 };
 
 class Lexer {
 public:
-    explicit Lexer(const std::string &source);
+    explicit Lexer(std::string_view source, int firstLine = 1);
+    Lexer(std::string_view source, size_t begin, size_t end, int firstLine = 1, int firstColumn = 1);
+
+    static constexpr size_t maxLookahead = 4;
 
     Token nextToken();
-    Token peekToken();
+    const Token& peekToken(size_t k = 0);
+
+    std::string_view sourceText() const { return source; }
+    const SourceManager& sourceManager() const;
+
+    static std::string describeError(const Token& tok);
 
 private:
-    std::string source;
+    std::string_view source;
     size_t length;
     size_t pos = 0;
-    int line = 1;
-    int col = 1;
+    int firstLine;
+    int firstColumn = 1;
+    mutable std::unique_ptr<SourceManager> lines;
+    Arena strings;
+
+    std::array<Token, maxLookahead> lookahead{};
+    size_t lookaheadHead = 0;
+    size_t lookaheadCount = 0;
 
+    Token lexToken();
     char peek(size_t offset = 0) const;
     char advance();
     bool match(char expected);
+    std::string_view text(size_t start) const;
+    Token makeToken(TokenType type, size_t start) const;
+    Token errorToken(const char* message, size_t start, size_t at) const;
 
-    void skipWhitespaceAndComments();
+    bool skipWhitespaceAndComments();
 
     Token identifierOrKeyword();
     Token number();
     Token string();
     Token _char();
-
-    LexerError error(const std::string &msg) const;
-    std::string getCurrentLine() const;
+    std::string_view unescape(std::string_view body);
 };
@@ -0,0 +1,33 @@
+#pragma once
+#include "ast.hpp"
+#include "error.hpp"
+#include <cstdint>
+#include <vector>
+
+// Warns about lets that are never referenced. Runs after the resolver and
+// relies on its stack-ordered slots: the latest declaration walked for a
+// slot is the binding every reference to that slot sees. Names starting
+// with `_` are exempt.
+class Linter {
+public:
+    void lint(const Function& fn, size_t offset, std::vector<Diagnostic>& diagnostics);
+
+private:
+    struct Local {
+        const LetDecl* let;
+        bool used;
+    };
+
+    struct Work {
+        const ASTNode* node;
+        bool declare;
+    };
+
+    std::vector<Local> locals;
+    std::vector<uint32_t> owners;
+    std::vector<Work> work;
+
+    void push(const ASTNode* node);
+    void pushList(const ASTList& list);
+    void visit(const ASTNode* node);
+};
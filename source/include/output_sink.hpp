@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+class OutputSink {
+public:
+    static constexpr size_t defaultCapacity = 256 * 1024;
+
+    explicit OutputSink(int target = 1, size_t bufferSize = defaultCapacity);
+    ~OutputSink();
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    void write(std::string_view s) {
+        if (s.size() > capacity - used) {
+            writeSlow(s);
+            return;
+        }
+        std::memcpy(buffer.get() + used, s.data(), s.size());
+        used += s.size();
+    }
+
+    void put(char c) {
+        if (used == capacity) flush();
+        buffer[used++] = c;
+    }
+
+    void pad(int n);
+    void writeInt(int64_t value);
+    void writeDouble(double value);
+    void writeShortestDouble(double value);
+
+    bool flush();
+    bool ok() const { return !failed; }
+
+private:
+    int fd;
+    size_t capacity;
+    size_t used = 0;
+    std::unique_ptr<char[]> buffer;
+    bool failed = false;
+
+    void writeSlow(std::string_view s);
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include "ast.hpp"
+#include "error.hpp"
+#include "parser.hpp"
+#include <memory>
+#include <string_view>
+#include <vector>
+
+ProgramItem parseItem(std::string_view source, SourceSpan span, AstArena& arena,
+                      std::vector<Function*>& out, std::vector<Diagnostic>& diagnostics,
+                      unsigned maxNesting);
+
+std::unique_ptr<Program> parseParallel(std::string_view source, unsigned jobs,
+                                       std::vector<Diagnostic>& diagnostics,
+                                       unsigned maxNesting = Parser::defaultMaxNesting);
@@ -0,0 +1,28 @@
+#pragma once
+#include "ast.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+class ParseCache {
+public:
+    static constexpr uintmax_t defaultMaxBytes = uintmax_t(256) << 20;
+
+    static ParseCache fromEnvironment();
+
+    explicit ParseCache(std::filesystem::path directory, uintmax_t maxBytes = defaultMaxBytes);
+
+    bool enabled() const { return !dir.empty(); }
+
+    std::unique_ptr<Program> load(std::string_view source, unsigned maxNesting) const;
+    void store(std::string_view source, unsigned maxNesting, const Program& program) const;
+
+private:
+    std::filesystem::path dir;
+    uintmax_t maxBytes;
+
+    static uint64_t key(std::string_view source, unsigned maxNesting);
+    std::filesystem::path entryPath(uint64_t key) const;
+    void evict() const;
+};
@@ -1,36 +1,64 @@
 #pragma once
 #include "lexer.hpp"
 #include "ast.hpp"
+#include "error.hpp"
+#include "token_buffer.hpp"
+#include <vector>
 
 class Parser {
 public:
-    explicit Parser(Lexer &lex) : lexer(lex) {
+    static constexpr unsigned defaultMaxNesting = 1000;
+
+    explicit Parser(Lexer &lex) : lexer(&lex) {
+        advance();
+    }
+
+    explicit Parser(const TokenBuffer &buffer) : tokens(&buffer) {
         advance();
     }
 
     std::unique_ptr<Program> parseProgram();
+    void parseInto(AstArena &target, std::vector<Function*> &out);
+
+    const std::vector<Diagnostic>& diagnostics() const { return diags; }
+    void setMaxNesting(unsigned limit) { maxNesting = limit; }
 
 private:
-    Lexer &lexer;
+    Lexer *lexer = nullptr;
+    const TokenBuffer *tokens = nullptr;
+    size_t index = 0;
     Token current;
+    AstArena *arena = nullptr;
+    size_t functionStart = 0;
+    std::vector<Diagnostic> diags;
+    bool panicking = false;
+    unsigned depth = 0;
+    unsigned maxNesting = defaultMaxNesting;
 
     void advance();
+    Token peek(size_t k = 0);
     bool check(TokenType type) const;
     bool match(TokenType type);
-    void expect(TokenType type, const std::string &msg);
+    bool expect(TokenType type, const char *what);
+    void error(std::string msg);
+    void synchronize();
     bool isTypeToken(TokenType t) const;
+    bool nest();
+
+    template <typename T, typename... Args>
+    T* make(size_t offset, Args&&... args) {
+        T* node = arena->make<T>(std::forward<Args>(args)...);
+        node->offset = static_cast<uint32_t>(offset - functionStart);
+        return node;
+    }
 
-    ASTPtr parseFunction();
+    Function* parseFunction();
     ASTPtr parseStatement();
     ASTPtr parseLetDecl();
-    ASTPtr parseIfStmt();
-    ASTPtr parseReturnStmt();
+    ASTPtr parseIfStmt(size_t offset);
+    ASTPtr parseReturnStmt(size_t offset);
     ASTPtr parseExpression();
-    ASTPtr parseEquality();
-    ASTPtr parseComparison();
-    ASTPtr parseTerm();
-    ASTPtr parseFactor();
     ASTPtr parsePrimary();
     ASTPtr parseCallOrVar();
-    std::vector<ASTPtr> parseBlock();
+    bool parseBlock(ASTList &out);
 };
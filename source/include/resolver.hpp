@@ -0,0 +1,46 @@
+#pragma once
+#include "ast.hpp"
+#include "error.hpp"
+#include "signature_table.hpp"
+#include <cstdint>
+#include <vector>
+
+// Binds every VarExpr and LetDecl of a function to a frame slot and every
+// CallExpr to an index into Program::functions. Parameters take the first
+// slots; a slot is reused once the scope that declared it closes.
+class Resolver {
+public:
+    explicit Resolver(const SignatureTable& table) : functions(table) {}
+
+    void resolve(Function& fn, size_t offset, std::vector<Diagnostic>& diagnostics);
+
+private:
+    struct Binding {
+        Symbol name;
+        uint32_t shadowed;
+    };
+
+    enum class Op : uint8_t { Visit, Declare, OpenScope, CloseScope };
+
+    struct Work {
+        Op op;
+        ASTNode* node;
+    };
+
+    const SignatureTable& functions;
+    std::vector<Binding> bindings;
+    std::vector<uint32_t> scopes;
+    std::vector<uint32_t> innermost;
+    std::vector<Work> work;
+    size_t base = 0;
+    std::vector<Diagnostic>* diags = nullptr;
+    uint32_t frameSize = 0;
+
+    uint32_t& binding(Symbol name);
+    uint32_t lookup(Symbol name) const;
+    uint32_t declare(Symbol name, size_t offset);
+    void closeScope();
+    void visit(ASTNode* node);
+    void pushList(const ASTList& list);
+    void error(std::string message, size_t offset);
+};
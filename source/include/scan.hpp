@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace scan {
+
+const char* skipSpace(const char* p, const char* end);
+const char* findByte(const char* p, const char* end, char c);
+const char* findCommentEnd(const char* p, const char* end);
+void collectNewlines(const char* begin, const char* end, std::vector<size_t>& out);
+
+const char* isaName();
+
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "ast.hpp"
+#include "error.hpp"
+#include <vector>
+
+// Resolves, type-checks and lints every function, spreading the functions
+// over `jobs` threads. The diagnostics come back sorted by offset and do
+// not depend on how the work was scheduled.
+void analyzeProgram(Program& program, std::vector<Diagnostic>& diagnostics, unsigned jobs = 1);
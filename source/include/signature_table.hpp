@@ -0,0 +1,31 @@
+#pragma once
+#include "ast.hpp"
+#include "error.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct Signature {
+    Symbol name;
+    VarType returnType;
+    ArenaList<Param> params;
+};
+
+// Collected once before the per-function passes run and only read from
+// then on, so those passes can share it across threads.
+class SignatureTable {
+public:
+    SignatureTable(const Program& program, std::vector<Diagnostic>& diagnostics);
+
+    uint32_t find(Symbol name) const {
+        auto it = indices.find(name);
+        return it == indices.end() ? unbound : it->second;
+    }
+
+    const Signature& operator[](uint32_t index) const { return signatures[index]; }
+    size_t size() const { return signatures.size(); }
+
+private:
+    std::vector<Signature> signatures;
+    std::unordered_map<Symbol, uint32_t> indices;
+};
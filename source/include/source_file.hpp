@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+class SourceFile {
+public:
+    SourceFile() = default;
+    ~SourceFile();
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    bool open(const std::string& path);
+
+    std::string_view text() const { return {data, size}; }
+    bool isMapped() const { return mapped; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    std::string owned;
+
+    bool map(int fd, size_t length);
+    bool readAll(int fd);
+    void release();
+};
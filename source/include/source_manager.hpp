@@ -0,0 +1,36 @@
+#pragma once
+#include <string_view>
+#include <vector>
+
+struct SourceSpan {
+    size_t begin;
+    size_t end;
+};
+
+struct SourceLocation {
+    int line;
+    int col;
+};
+
+class SourceManager {
+public:
+    static constexpr int tabSize = 4;
+
+    // The text may start partway into its first line, at firstColumn.
+    explicit SourceManager(std::string_view text, int firstLine = 1, int firstColumn = 1);
+
+    static int advanceColumn(int col, std::string_view text);
+
+    SourceLocation location(size_t offset) const;
+    std::string_view lineText(size_t offset) const;
+    int lineColumn(size_t offset) const;
+    size_t lineCount() const { return lineStarts.size(); }
+
+private:
+    std::string_view text;
+    int firstLine;
+    int firstColumn;
+    std::vector<size_t> lineStarts;
+
+    size_t lineIndex(size_t offset) const;
+};
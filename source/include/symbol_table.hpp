@@ -0,0 +1,99 @@
+#pragma once
+#include "arena.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+struct Symbol {
+    uint32_t id = 0;
+
+    std::string_view str() const;
+
+    bool operator==(Symbol other) const { return id == other.id; }
+    bool operator!=(Symbol other) const { return id != other.id; }
+    bool operator<(Symbol other) const { return id < other.id; }
+};
+
+namespace std {
+template <>
+struct hash<Symbol> {
+    size_t operator()(Symbol s) const { return s.id; }
+};
+}
+
+class SymbolTable {
+public:
+    static constexpr uint32_t chunkBits = 12;
+    static constexpr uint32_t chunkSize = 1u << chunkBits;
+    static constexpr uint32_t maxChunks = 1u << 12;
+    static constexpr uint32_t capacity = chunkSize * maxChunks;
+
+    SymbolTable();
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    Symbol intern(std::string_view s, size_t hash);
+    Symbol intern(std::string_view s) { return intern(s, std::hash<std::string_view>()(s)); }
+
+    std::string_view str(Symbol s) const {
+        const std::string_view* chunk = chunks[s.id >> chunkBits].load(std::memory_order_acquire);
+        return chunk[s.id & (chunkSize - 1)];
+    }
+
+    size_t size() const { return count.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        uint32_t hash;
+        uint32_t index;
+    };
+
+    static constexpr uint32_t emptySlot = UINT32_MAX;
+
+    Arena storage;
+    std::unique_ptr<std::atomic<std::string_view*>[]> chunks;
+    std::vector<std::unique_ptr<std::string_view[]>> owned;
+    std::vector<Slot> slots;
+    std::atomic<uint32_t> count{0};
+
+    void grow();
+};
+
+class ConcurrentSymbolTable {
+public:
+    static constexpr uint32_t shardBits = 4;
+    static constexpr uint32_t shardCount = 1u << shardBits;
+
+    ConcurrentSymbolTable();
+
+    static ConcurrentSymbolTable& global();
+
+    Symbol intern(std::string_view s) { return intern(s, std::hash<std::string_view>()(s)); }
+    Symbol intern(std::string_view s, size_t hash);
+
+    std::string_view str(Symbol s) const {
+        return shards[s.id & (shardCount - 1)].table.str(Symbol{s.id >> shardBits});
+    }
+
+    size_t size() const;
+
+private:
+    struct alignas(64) Shard {
+        std::mutex lock;
+        SymbolTable table;
+    };
+
+    std::array<Shard, shardCount> shards;
+};
+
+Symbol intern(std::string_view s);
+
+inline std::string_view Symbol::str() const {
+    return ConcurrentSymbolTable::global().str(*this);
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+unsigned defaultJobCount();
+
+void parallelFor(size_t count, unsigned workers, size_t grain,
+                 const std::function<void(size_t index, unsigned worker)>& body);
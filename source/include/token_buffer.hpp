@@ -0,0 +1,27 @@
+#pragma once
+#include "lexer.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class TokenBuffer {
+public:
+    explicit TokenBuffer(Lexer& lexer);
+
+    size_t size() const { return types.size(); }
+    size_t bytes() const;
+
+    TokenType type(size_t i) const { return types[i]; }
+    uint32_t offset(size_t i) const { return offsets[i]; }
+    std::string_view lexeme(size_t i) const { return source.substr(offsets[i], lengths[i]); }
+    Token token(size_t i) const;
+
+private:
+    std::string_view source;
+    std::vector<TokenType> types;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<Symbol> symbols;
+    std::vector<uint32_t> literalIndex;
+    std::vector<Token> literals;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include "ast.hpp"
+#include "error.hpp"
+#include "signature_table.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Stores a VarType on every Expr of a resolved function. Int promotes to
+// Float in arithmetic, comparisons and assignments; every other
+// combination has to match exactly. An expression that already failed to
+// check (or names something unbound) is not reported again by its parents.
+class TypeChecker {
+public:
+    explicit TypeChecker(const SignatureTable& table) : functions(table) {}
+
+    void check(Function& fn, size_t offset, std::vector<Diagnostic>& diagnostics);
+
+private:
+    // A null node discards the value of an expression statement.
+    struct Work {
+        ASTNode* node;
+        bool leaving;
+    };
+
+    struct Value {
+        VarType type;
+        bool valid;
+    };
+
+    const SignatureTable& functions;
+    std::vector<Work> work;
+    std::vector<Value> values;
+    std::vector<VarType> slots;
+    const Function* function = nullptr;
+    size_t base = 0;
+    std::vector<Diagnostic>* diags = nullptr;
+
+    void enter(ASTNode* node);
+    void leave(ASTNode* node);
+    void push(ASTNode* node);
+    void pushList(const ASTList& list);
+    void pushStatements(const ASTList& list);
+    Value operand(const ASTNode* child);
+    void result(ASTNode* node, VarType type, bool valid = true);
+    void checkBinary(BinaryExpr& n);
+    void checkCall(CallExpr& n);
+    void error(std::string message, const ASTNode& at);
+};
@@ -0,0 +1,101 @@
+#include "chunked_reader.hpp"
+#include "scan.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+ChunkedReader::ChunkedReader(size_t size) : chunkSize(size) {}
+
+ChunkedReader::~ChunkedReader() {
+#ifdef _WIN32
+    if (ownsFd) _close(fd);
+#else
+    if (ownsFd) ::close(fd);
+#endif
+}
+
+bool ChunkedReader::open(const std::string& path) {
+    if (path == "-") {
+        fd = 0;
+        return true;
+    }
+#ifdef _WIN32
+    fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+#endif
+    ownsFd = fd >= 0;
+    return ownsFd;
+}
+
+bool ChunkedReader::fill() {
+    size_t old = buffer.size();
+    buffer.resize(old + chunkSize);
+#ifdef _WIN32
+    int n = _read(fd, &buffer[old], static_cast<unsigned>(chunkSize));
+#else
+    ssize_t n = ::read(fd, &buffer[old], chunkSize);
+#endif
+    if (n < 0) throw std::runtime_error("Read error on streamed input");
+    buffer.resize(old + static_cast<size_t>(n));
+    peak = std::max(peak, buffer.capacity());
+    return n > 0;
+}
+
+// Keeps up to one chunk of the line the next item begins on, so its
+// diagnostics can show that line. Each released byte is scanned for
+// newlines once and for its column at most once, and the buffer is only
+// compacted once the text in front of the context reaches a chunk.
+void ChunkedReader::release() {
+    if (released == 0) return;
+    const char* data = buffer.data();
+    for (const char* p = data + itemStart, *end = data + released;
+         (p = scan::findByte(p, end, '\n')) != end; p++) {
+        firstLine++;
+        context = static_cast<size_t>(p - data) + 1;
+        firstColumn = 1;
+    }
+    if (released > context + chunkSize) {
+        size_t start = released - chunkSize;
+        firstColumn = SourceManager::advanceColumn(firstColumn, std::string_view(buffer).substr(context, start - context));
+        context = start;
+    }
+    itemStart = released;
+    released = 0;
+
+    if (context >= chunkSize) {
+        consumed += context;
+        buffer.erase(0, context);
+        scanPos -= context;
+        itemStart -= context;
+        context = 0;
+    }
+}
+
+std::string_view ChunkedReader::itemLines() const {
+    return std::string_view(buffer).substr(context, released + chunkSize - context);
+}
+
+bool ChunkedReader::nextItem(std::string_view& item) {
+    release();
+    while (true) {
+        if (splitter.next(buffer, scanPos, eof)) {
+            released = scanPos;
+            item = std::string_view(buffer).substr(itemStart, released - itemStart);
+            return true;
+        }
+        if (eof) {
+            if (buffer.size() == itemStart) return false;
+            released = buffer.size();
+            item = std::string_view(buffer).substr(itemStart);
+            return true;
+        }
+        if (!fill()) eof = true;
+    }
+}
@@ -0,0 +1,86 @@
+#include "output_sink.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+OutputSink::OutputSink(int target, size_t bufferSize)
+    : fd(target), capacity(bufferSize), buffer(new char[bufferSize]) {}
+
+OutputSink::~OutputSink() {
+    flush();
+}
+
+bool OutputSink::flush() {
+    const char* p = buffer.get();
+    size_t left = used;
+    used = 0;
+    while (left > 0 && !failed) {
+#ifdef _WIN32
+        int n = _write(fd, p, static_cast<unsigned>(left));
+#else
+        ssize_t n = ::write(fd, p, left);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            failed = true;
+            break;
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    return !failed;
+}
+
+void OutputSink::writeSlow(std::string_view s) {
+    while (!s.empty()) {
+        if (used == capacity) flush();
+        size_t n = std::min(s.size(), capacity - used);
+        std::memcpy(buffer.get() + used, s.data(), n);
+        used += n;
+        s.remove_prefix(n);
+    }
+}
+
+void OutputSink::pad(int n) {
+    static constexpr char spaces[] = "                                                                ";
+    constexpr int chunk = sizeof(spaces) - 1;
+    for (; n > chunk; n -= chunk) write({spaces, chunk});
+    if (n > 0) write({spaces, static_cast<size_t>(n)});
+}
+
+void OutputSink::writeInt(int64_t value) {
+    char digits[24];
+    auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    write({digits, static_cast<size_t>(res.ptr - digits)});
+}
+
+void OutputSink::writeDouble(double value) {
+    char digits[32];
+    int n = std::snprintf(digits, sizeof(digits), "%g", value);
+    write({digits, static_cast<size_t>(n)});
+}
+
+// Without floating-point to_chars (older libstdc++, Apple's libc++), the
+// fewest %g digits that read back as the same value are used instead.
+void OutputSink::writeShortestDouble(double value) {
+    char digits[32];
+#if defined(__cpp_lib_to_chars)
+    auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    write({digits, static_cast<size_t>(res.ptr - digits)});
+#else
+    int n = 0;
+    for (int precision = 15; precision <= 17; precision++) {
+        n = std::snprintf(digits, sizeof(digits), "%.*g", precision, value);
+        if (std::strtod(digits, nullptr) == value) break;
+    }
+    write({digits, static_cast<size_t>(n)});
+#endif
+}
@@ -0,0 +1,159 @@
+#include "parse_cache.hpp"
+#include "ast_serializer.hpp"
+#include "hash.hpp"
+#include "parser_revision.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifndef ESHARP_VERSION
+#define ESHARP_VERSION "dev"
+#endif
+
+namespace fs = std::filesystem;
+
+// An entry starts with the source size, the key and a second hash of the
+// source under an unrelated seed, so a key collision is not taken as a hit,
+// followed by a hash of the serialized tree so a damaged entry is a miss.
+static constexpr size_t entryHeaderSize = 32;
+
+static uint64_t keySeed() {
+    static const uint64_t seed = hash64(std::string(ESHARP_VERSION) + "/" + ESHARP_PARSER_REVISION + "/ast" +
+                                        std::to_string(astFormatVersion));
+    return seed;
+}
+
+static uint64_t checksum(std::string_view source) {
+    static const uint64_t seed = hash64(std::string("check/") + ESHARP_PARSER_REVISION);
+    return hash64(source, seed);
+}
+
+static void putFixed(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+static uint64_t getFixed(const char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+ParseCache ParseCache::fromEnvironment() {
+    fs::path directory;
+    if (const char* dir = std::getenv("ESHARP_CACHE_DIR"); dir && *dir)
+        directory = dir;
+    else if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+        directory = fs::path(xdg) / "esharp";
+    else if (const char* home = std::getenv("HOME"); home && *home)
+        directory = fs::path(home) / ".cache" / "esharp";
+
+    uintmax_t limit = defaultMaxBytes;
+    if (const char* size = std::getenv("ESHARP_CACHE_SIZE_MB"); size && *size) {
+        char* last = nullptr;
+        unsigned long long mb = std::strtoull(size, &last, 10);
+        if (*last == '\0') limit = static_cast<uintmax_t>(mb) << 20;
+    }
+    return ParseCache(directory, limit);
+}
+
+ParseCache::ParseCache(fs::path directory, uintmax_t limit)
+    : dir(std::move(directory)), maxBytes(limit) {}
+
+uint64_t ParseCache::key(std::string_view source, unsigned maxNesting) {
+    return hash64(source, keySeed() + maxNesting);
+}
+
+fs::path ParseCache::entryPath(uint64_t key) const {
+    static const char digits[] = "0123456789abcdef";
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; i--, key >>= 4) name[i] = digits[key & 0xF];
+    return dir / (name + ".ast");
+}
+
+std::unique_ptr<Program> ParseCache::load(std::string_view source, unsigned maxNesting) const {
+    if (!enabled()) return nullptr;
+    uint64_t id = key(source, maxNesting);
+    fs::path path = entryPath(id);
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return nullptr;
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bytes.size() < entryHeaderSize || getFixed(bytes.data()) != source.size() ||
+        getFixed(bytes.data() + 8) != id || getFixed(bytes.data() + 16) != checksum(source))
+        return nullptr;
+
+    std::string_view payload = std::string_view(bytes).substr(entryHeaderSize);
+    auto program = getFixed(bytes.data() + 24) == hash64(payload) ? deserializeProgram(payload) : nullptr;
+    std::error_code ec;
+    if (program) fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    else fs::remove(path, ec);
+    return program;
+}
+
+void ParseCache::store(std::string_view source, unsigned maxNesting, const Program& program) const {
+    if (!enabled()) return;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) return;
+
+    uint64_t id = key(source, maxNesting);
+    std::string bytes;
+    putFixed(bytes, source.size());
+    putFixed(bytes, id);
+    putFixed(bytes, checksum(source));
+    std::string payload = serializeProgram(program);
+    putFixed(bytes, hash64(payload));
+    bytes += payload;
+    if (bytes.size() > maxBytes) return;
+
+    fs::path path = entryPath(id);
+    fs::path tmp = path;
+    tmp += ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!out) {
+            out.close();
+            fs::remove(tmp, ec);
+            return;
+        }
+    }
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return;
+    }
+    evict();
+}
+
+void ParseCache::evict() const {
+    struct Entry {
+        fs::path path;
+        uintmax_t size;
+        fs::file_time_type used;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".ast") continue;
+        std::error_code entryError;
+        uintmax_t size = it->file_size(entryError);
+        fs::file_time_type used = it->last_write_time(entryError);
+        if (entryError) continue;
+        entries.push_back({it->path(), size, used});
+        total += size;
+    }
+    if (total <= maxBytes) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const Entry& e : entries) {
+        if (total <= maxBytes) break;
+        if (fs::remove(e.path, ec)) total -= e.size;
+    }
+}
@@ -0,0 +1,85 @@
+#include "source_file.hpp"
+#include <cstdio>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile::~SourceFile() {
+    release();
+}
+
+void SourceFile::release() {
+#ifndef _WIN32
+    if (mapped) munmap(const_cast<char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+    mapped = false;
+    owned.clear();
+}
+
+bool SourceFile::open(const std::string& path) {
+    release();
+
+    if (path == "-") return readAll(0);
+
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+    if (fd < 0) return false;
+    bool ok = readAll(fd);
+    _close(fd);
+    return ok;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool ok;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        ok = map(fd, static_cast<size_t>(st.st_size)) || readAll(fd);
+    else
+        ok = readAll(fd);
+    ::close(fd);
+    return ok;
+#endif
+}
+
+bool SourceFile::map(int fd, size_t length) {
+#ifdef _WIN32
+    (void)fd; (void)length;
+    return false;
+#else
+    void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) return false;
+#ifdef MADV_SEQUENTIAL
+    madvise(p, length, MADV_SEQUENTIAL);
+#endif
+    data = static_cast<const char*>(p);
+    size = length;
+    mapped = true;
+    return true;
+#endif
+}
+
+bool SourceFile::readAll(int fd) {
+    char chunk[1 << 16];
+    while (true) {
+#ifdef _WIN32
+        int n = _read(fd, chunk, sizeof(chunk));
+#else
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+#endif
+        if (n < 0) return false;
+        if (n == 0) break;
+        owned.append(chunk, static_cast<size_t>(n));
+    }
+    data = owned.data();
+    size = owned.size();
+    return true;
+}
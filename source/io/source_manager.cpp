@@ -0,0 +1,41 @@
+#include "source_manager.hpp"
+#include "scan.hpp"
+#include <algorithm>
+
+SourceManager::SourceManager(std::string_view src, int first, int column)
+    : text(src), firstLine(first), firstColumn(column) {
+    std::vector<size_t> newlines;
+    scan::collectNewlines(text.data(), text.data() + text.size(), newlines);
+    lineStarts.reserve(newlines.size() + 1);
+    lineStarts.push_back(0);
+    for (size_t nl : newlines) lineStarts.push_back(nl + 1);
+}
+
+size_t SourceManager::lineIndex(size_t offset) const {
+    auto it = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+    return static_cast<size_t>(it - lineStarts.begin()) - 1;
+}
+
+int SourceManager::advanceColumn(int col, std::string_view text) {
+    for (char c : text) col += c == '\t' ? tabSize - ((col - 1) % tabSize) : 1;
+    return col;
+}
+
+SourceLocation SourceManager::location(size_t offset) const {
+    offset = std::min(offset, text.size());
+    size_t idx = lineIndex(offset);
+    int col = advanceColumn(idx == 0 ? firstColumn : 1, text.substr(lineStarts[idx], offset - lineStarts[idx]));
+    return {firstLine + static_cast<int>(idx), col};
+}
+
+std::string_view SourceManager::lineText(size_t offset) const {
+    offset = std::min(offset, text.size());
+    size_t start = lineStarts[lineIndex(offset)];
+    size_t end = text.find('\n', start);
+    if (end == std::string_view::npos) end = text.size();
+    return text.substr(start, end - start);
+}
+
+int SourceManager::lineColumn(size_t offset) const {
+    return lineIndex(std::min(offset, text.size())) == 0 ? firstColumn : 1;
+}
@@ -1,32 +1,270 @@
+#include "ast_dumper.hpp"
+#include "ast_image.hpp"
+#include "chunked_reader.hpp"
+#include "flat_ast.hpp"
+#include "flat_dump.hpp"
+#include "parallel_parser.hpp"
+#include "parse_cache.hpp"
 #include "parser.hpp"
+#include "sema.hpp"
+#include "source_file.hpp"
+#include "thread_pool.hpp"
+#include "token_buffer.hpp"
+#include <algorithm>
 #include <fstream>
-#include <sstream>
 #include <iostream>
+#include <string>
 
-int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <source file>\n";
+struct Options {
+    std::string path;
+    std::string emitAst;
+    std::string function;
+    bool pretokenize = false;
+    bool stats = false;
+    bool stream = false;
+    bool flat = false;
+    bool noCache = false;
+    bool check = false;
+    DumpFormat dump = DumpFormat::Text;
+    unsigned jobs = 1;
+    unsigned maxNesting = Parser::defaultMaxNesting;
+};
+
+static bool parseCount(const std::string& value, unsigned& count) {
+    try {
+        size_t used = 0;
+        unsigned long n = std::stoul(value, &used);
+        if (used != value.size() || n == 0) return false;
+        count = static_cast<unsigned>(n);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+static bool parseJobs(const std::string& value, unsigned& jobs) {
+    if (value == "0") {
+        jobs = defaultJobCount();
+        return true;
+    }
+    return parseCount(value, jobs);
+}
+
+static bool parseArgs(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--pretokenize") opts.pretokenize = true;
+        else if (arg == "--stats") opts.stats = true;
+        else if (arg == "--stream") opts.stream = true;
+        else if (arg == "--flat") opts.flat = true;
+        else if (arg == "--no-cache") opts.noCache = true;
+        else if (arg == "--check") opts.check = true;
+        else if (arg.rfind("--dump=", 0) == 0) {
+            if (!parseDumpFormat(arg.substr(7), opts.dump)) return false;
+        }
+        else if (arg == "-j" && i + 1 < argc) {
+            if (!parseJobs(argv[++i], opts.jobs)) return false;
+        } else if (arg.rfind("-j", 0) == 0 && arg.size() > 2) {
+            if (!parseJobs(arg.substr(2), opts.jobs)) return false;
+        } else if (arg == "--max-nesting" && i + 1 < argc) {
+            if (!parseCount(argv[++i], opts.maxNesting)) return false;
+        } else if (arg == "--emit-ast" && i + 1 < argc) opts.emitAst = argv[++i];
+        else if (arg == "--function" && i + 1 < argc) opts.function = argv[++i];
+        else if (arg.size() > 1 && arg[0] == '-' && arg != "-") return false;
+        else if (opts.path.empty()) opts.path = arg;
+        else return false;
+    }
+    // --stream only parses and dumps, one item at a time.
+    if (opts.stream && (opts.pretokenize || opts.flat || opts.check || opts.jobs != 1 || !opts.emitAst.empty() ||
+                        !opts.function.empty()))
+        return false;
+    return !opts.path.empty();
+}
+
+static void printArenaStats(const Program& program) {
+    std::cerr << "ast nodes: " << program.nodeCount() << "\n";
+    std::cerr << "ast arenas: " << program.arenas.size() << "\n";
+    std::cerr << "ast arena bytes: " << program.bytesUsed()
+              << " used, " << program.bytesReserved() << " reserved\n";
+}
+
+static void printDiagnostics(const std::vector<Diagnostic>& diagnostics, const SourceManager& sources) {
+    for (const auto& diag : diagnostics)
+        std::cerr << (isWarning(diag.stage) ? "Warning: " : "Error: ") << formatDiagnostic(diag, sources) << "\n";
+}
+
+static bool hasErrors(const std::vector<Diagnostic>& diagnostics) {
+    return std::any_of(diagnostics.begin(), diagnostics.end(),
+                       [](const Diagnostic& diag) { return !isWarning(diag.stage); });
+}
+
+static int runStreaming(const Options& opts) {
+    ChunkedReader reader;
+    if (!reader.open(opts.path)) {
+        std::cerr << "Could not open file: " << opts.path << "\n";
         return 1;
     }
 
-    std::ifstream file(argv[1]);
-    if (!file) {
-        std::cerr << "Could not open file: " << argv[1] << "\n";
+    bool failed = false;
+    OutputSink out;
+    try {
+        ProgramDumpStream program(out, opts.dump);
+        std::string_view item;
+        while (reader.nextItem(item)) {
+            Lexer lexer(reader.itemLines(), reader.itemBegin(), reader.itemBegin() + item.size(),
+                        reader.itemFirstLine(), reader.itemFirstColumn());
+            Parser parser(lexer);
+            parser.setMaxNesting(opts.maxNesting);
+            auto ast = parser.parseProgram();
+            if (!parser.diagnostics().empty()) {
+                out.flush();
+                printDiagnostics(parser.diagnostics(), lexer.sourceManager());
+                failed = true;
+                continue;
+            }
+            for (const auto& fn : ast->functions) program.add(*fn);
+        }
+        program.finish();
+    } catch (const std::exception &ex) {
+        out.flush();
+        std::cerr << "Error: " << ex.what() << "\n";
         return 1;
     }
+    if (failed) return 1;
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
+    if (opts.stats)
+        std::cerr << "peak stream buffer bytes: " << reader.peakBufferSize() << "\n";
+    return 0;
+}
 
-    try {
-        Lexer lexer(buffer.str());
+static int runImage(const Options& opts, std::string_view bytes) {
+    AstImage image;
+    if (!image.attach(bytes) || !image.verify()) {
+        std::cerr << "Error: Invalid AST image: " << opts.path << "\n";
+        return 1;
+    }
+    if (opts.stats) {
+        std::cerr << "ast image nodes: " << image.nodeCount() << "\n";
+        std::cerr << "ast image bytes: " << bytes.size() << "\n";
+    }
+    OutputSink out;
+    if (opts.function.empty()) {
+        image.dump(out, opts.dump);
+        return 0;
+    }
+    AstImage::Index fn = image.findFunction(opts.function);
+    if (fn == AstImage::none) {
+        std::cerr << "Error: No function named " << opts.function << "\n";
+        return 1;
+    }
+    dumpFlat(image, fn, out, opts.dump);
+    return 0;
+}
+
+static bool writeImage(const std::string& path, const Program& program) {
+    std::string image = AstImage::encode(FlatAst::fromTree(program));
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(image.data(), static_cast<std::streamsize>(image.size()));
+    return static_cast<bool>(out.flush());
+}
+
+static const Function* findFunction(const Program& program, const std::string& name) {
+    Symbol target = intern(name);
+    for (const Function* fn : program.functions)
+        if (fn->name == target) return fn;
+    return nullptr;
+}
+
+static std::unique_ptr<Program> parseSource(const Options& opts, Lexer& lexer,
+                                            std::vector<Diagnostic>& diagnostics) {
+    if (opts.jobs > 1) return parseParallel(lexer.sourceText(), opts.jobs, diagnostics, opts.maxNesting);
+
+    std::unique_ptr<Program> ast;
+    if (opts.pretokenize) {
+        TokenBuffer tokens(lexer);
+        if (opts.stats) {
+            std::cerr << "tokens: " << tokens.size() << "\n";
+            std::cerr << "token buffer bytes: " << tokens.bytes() << "\n";
+        }
+        Parser parser(tokens);
+        parser.setMaxNesting(opts.maxNesting);
+        ast = parser.parseProgram();
+        diagnostics = parser.diagnostics();
+    } else {
         Parser parser(lexer);
-        auto ast = parser.parseProgram();
-        ast->dump();
+        parser.setMaxNesting(opts.maxNesting);
+        ast = parser.parseProgram();
+        diagnostics = parser.diagnostics();
+    }
+    return ast;
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parseArgs(argc, argv, opts)) {
+        std::cerr << "Usage: " << argv[0] << " [--pretokenize] [--stream] [--flat] [--dump=text|json|sexpr] [--stats] [--no-cache] [--check] [-j N] [--max-nesting N] [--emit-ast FILE] [--function NAME] <source file | AST image | ->\n";
+        return 1;
+    }
+
+    if (opts.stream) return runStreaming(opts);
+
+    SourceFile file;
+    if (!file.open(opts.path)) {
+        std::cerr << "Could not open file: " << opts.path << "\n";
+        return 1;
+    }
+    if (AstImage::isImage(file.text())) return runImage(opts, file.text());
+
+    try {
+        Lexer lexer(file.text());
+        ParseCache cache = opts.noCache ? ParseCache({}) : ParseCache::fromEnvironment();
+        std::unique_ptr<Program> ast = cache.load(file.text(), opts.maxNesting);
+        if (opts.stats && cache.enabled()) std::cerr << "parse cache: " << (ast ? "hit" : "miss") << "\n";
+        if (!ast) {
+            std::vector<Diagnostic> diagnostics;
+            ast = parseSource(opts, lexer, diagnostics);
+            if (!diagnostics.empty()) {
+                printDiagnostics(diagnostics, lexer.sourceManager());
+                return 1;
+            }
+            cache.store(file.text(), opts.maxNesting, *ast);
+        }
+        if (opts.check) {
+            std::vector<Diagnostic> diagnostics;
+            analyzeProgram(*ast, diagnostics, opts.jobs);
+            printDiagnostics(diagnostics, lexer.sourceManager());
+            if (hasErrors(diagnostics)) return 1;
+        }
+        if (opts.stats) printArenaStats(*ast);
+        if (!opts.emitAst.empty()) {
+            if (!writeImage(opts.emitAst, *ast)) {
+                std::cerr << "Could not write file: " << opts.emitAst << "\n";
+                return 1;
+            }
+        } else if (!opts.function.empty()) {
+            const Function* fn = findFunction(*ast, opts.function);
+            if (!fn) {
+                std::cerr << "Error: No function named " << opts.function << "\n";
+                return 1;
+            }
+            OutputSink out;
+            dumpTree(*fn, out, opts.dump);
+        } else if (opts.flat) {
+            FlatAst flat = FlatAst::fromTree(*ast);
+            if (opts.stats) {
+                std::cerr << "flat ast nodes: " << flat.nodeCount() << "\n";
+                std::cerr << "flat ast bytes: " << flat.bytes() << "\n";
+            }
+            OutputSink out;
+            flat.dump(out, opts.dump);
+        } else {
+            OutputSink out;
+            dumpTree(*ast, out, opts.dump);
+        }
     } catch (const std::exception &ex) {
         std::cerr << "Error: " << ex.what() << "\n";
         return 1;
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,103 +1,97 @@
 #include "ast.hpp"
-#include <iostream>
 
-IntExpr::IntExpr(int64_t v) : value(v) {}
-void IntExpr::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Int(" << value << ")\n";
-}
+IntExpr::IntExpr(int64_t v) : Expr(NodeKind::Int), value(v) {}
 
-DoubleExpr::DoubleExpr(double v) : value(v) {}
-void DoubleExpr::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Double(" << value << ")\n";
-}
+DoubleExpr::DoubleExpr(double v) : Expr(NodeKind::Double), value(v) {}
 
-StringExpr::StringExpr(const std::string& v) : value(v) {}
-void StringExpr::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "String(" << value << ")\n";
-}
+StringExpr::StringExpr(std::string_view v) : Expr(NodeKind::String), value(v) {}
 
-CharExpr::CharExpr(char v) : value(v) {}
-void CharExpr::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Char('" << value << "')\n";
-}
+CharExpr::CharExpr(char v) : Expr(NodeKind::Char), value(v) {}
 
-BoolExpr::BoolExpr(bool v) : value(v) {}
-void BoolExpr::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Bool(" << value << ")\n";
-}
+BoolExpr::BoolExpr(bool v) : Expr(NodeKind::Bool), value(v) {}
 
-VoidExpr::VoidExpr() = default;
-void VoidExpr::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Void\n";
-}
+VoidExpr::VoidExpr() : Expr(NodeKind::Void) {}
+
+VarExpr::VarExpr(Symbol n) : Expr(NodeKind::Var), name(n) {}
+
+UnaryExpr::UnaryExpr(UnaryOp o, ASTPtr e)
+    : Expr(NodeKind::Unary), op(o), operand(e) {}
+
+BinaryExpr::BinaryExpr(BinaryOp o, ASTPtr l, ASTPtr r)
+    : Expr(NodeKind::Binary), op(o), left(l), right(r) {}
 
-VarExpr::VarExpr(const std::string& n) : name(n) {}
-void VarExpr::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Var(" << name << ")\n";
+CallExpr::CallExpr(Symbol c, ASTList a)
+    : Expr(NodeKind::Call), callee(c), args(a) {}
+
+ReturnStmt::ReturnStmt(ASTPtr v) : Stmt(NodeKind::Return), value(v) {}
+
+IfStmt::IfStmt(ASTPtr condition, ASTList thenB, ASTList elseB)
+    : Stmt(NodeKind::If), cond(condition), thenBranch(thenB), elseBranch(elseB) {}
+
+LetDecl::LetDecl(Symbol n, VarType t, ASTPtr i)
+    : Stmt(NodeKind::Let), name(n), type(t), init(i) {}
+
+BlockStmt::BlockStmt(ASTList stmts)
+    : Stmt(NodeKind::Block), statements(stmts) {}
+
+Function::Function(Symbol n, VarType rt, ArenaList<Param> p, BlockStmt* b)
+    : Stmt(NodeKind::Function), name(n), returnType(rt), params(p), body(b) {}
+
+Program::Program() : ASTNode(NodeKind::Program) {
+    arenas.push_back(std::make_unique<AstArena>());
 }
 
-BinaryExpr::BinaryExpr(const std::string& o, ASTPtr l, ASTPtr r)
-    : op(o), left(std::move(l)), right(std::move(r)) {}
-void BinaryExpr::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Binary(" << op << ")\n";
-    if (left) left->dump(indent + 2);
-    if (right) right->dump(indent + 2);
+void Program::adopt(std::unique_ptr<AstArena> other) {
+    arenas.push_back(std::move(other));
 }
 
-CallExpr::CallExpr(const std::string& c, std::vector<ASTPtr> a)
-    : callee(c), args(std::move(a)) {}
-void CallExpr::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Call(" << callee << ")\n";
-    for (const auto& arg : args) arg->dump(indent + 2);
+static void applyShift(ProgramItem& item, const ItemShift& shift) {
+    item.span.begin += shift.offset;
+    item.span.end += shift.offset;
+    item.firstFunction += shift.functions;
+    item.firstDiagnostic += shift.diagnostics;
 }
 
-ReturnStmt::ReturnStmt(ASTPtr v) : value(std::move(v)) {}
-void ReturnStmt::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Return\n";
-    if (value) value->dump(indent + 2);
+ProgramItem Program::item(size_t i) const {
+    ProgramItem out = items[i];
+    if (i >= pendingShift.from) applyShift(out, pendingShift);
+    return out;
 }
 
-IfStmt::IfStmt(ASTPtr condition, std::vector<ASTPtr> thenB, std::vector<ASTPtr> elseB)
-    : cond(std::move(condition)), thenBranch(std::move(thenB)), elseBranch(std::move(elseB)) {}
-void IfStmt::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "If\n";
-    if (cond) cond->dump(indent + 2);
-    std::cout << std::string(indent, ' ') << "Then:\n";
-    for (const auto& s : thenBranch) s->dump(indent + 2);
-    if (!elseBranch.empty()) {
-        std::cout << std::string(indent, ' ') << "Else:\n";
-        for (const auto& s : elseBranch) s->dump(indent + 2);
+size_t Program::functionOffset(size_t i) const {
+    size_t offset = functions[i]->start;
+    if (items.empty()) return offset;
+    size_t lo = 0, hi = items.size();
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (item(mid).firstFunction <= i) lo = mid;
+        else hi = mid;
     }
+    return item(lo).span.begin + offset;
 }
 
-LetDecl::LetDecl(const std::string& n, VarType t, ASTPtr i)
-    : name(n), type(t), init(std::move(i)) {}
-void LetDecl::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Let(" << name << ": " << toString(type) << ")\n";
-    if (init) init->dump(indent + 2);
+void Program::settleItems(size_t end) {
+    end = std::min(end, items.size());
+    for (size_t i = pendingShift.from; i < end; i++) applyShift(items[i], pendingShift);
+    if (end > pendingShift.from) pendingShift.from = end;
+    if (pendingShift.from >= items.size()) pendingShift = {};
 }
 
-BlockStmt::BlockStmt(std::vector<ASTPtr> stmts)
-    : statements(std::move(stmts)) {}
-void BlockStmt::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Block\n";
-    for (const auto& stmt : statements) stmt->dump(indent + 2);
+size_t Program::nodeCount() const {
+    size_t n = 0;
+    for (const auto& a : arenas) n += a->nodeCount();
+    return n;
 }
 
-Function::Function(const std::string& n, VarType rt,
-                   std::vector<std::pair<std::string, VarType>> p,
-                   std::unique_ptr<BlockStmt> b)
-    : name(n), returnType(rt), params(std::move(p)), body(std::move(b)) {}
-void Function::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Function " << name << " -> " << toString(returnType) << "\n";
-    for (const auto& param : params)
-        std::cout << std::string(indent + 2, ' ') << "Param: " << param.first << ": " << toString(param.second) << "\n";
-    if (body) body->dump(indent + 2);
+size_t Program::bytesUsed() const {
+    size_t n = 0;
+    for (const auto& a : arenas) n += a->bytesUsed();
+    return n;
 }
 
-void Program::dump(int indent) const {
-    std::cout << std::string(indent, ' ') << "Program\n";
-    for (const auto& func : functions) {
-        func->dump(indent + 2);
-    }
+size_t Program::bytesReserved() const {
+    size_t n = 0;
+    for (const auto& a : arenas) n += a->bytesReserved();
+    return n;
 }
+
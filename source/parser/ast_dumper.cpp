@@ -0,0 +1,535 @@
+#include "ast_dumper.hpp"
+#include "ast_visitor.hpp"
+
+bool parseDumpFormat(std::string_view name, DumpFormat& format) {
+    if (name == "text") format = DumpFormat::Text;
+    else if (name == "json") format = DumpFormat::Json;
+    else if (name == "sexpr") format = DumpFormat::Sexpr;
+    else return false;
+    return true;
+}
+
+static const char* kindName(NodeKind kind) {
+    switch (kind) {
+        case NodeKind::Int: return "Int";
+        case NodeKind::Double: return "Double";
+        case NodeKind::String: return "String";
+        case NodeKind::Char: return "Char";
+        case NodeKind::Bool: return "Bool";
+        case NodeKind::Void: return "Void";
+        case NodeKind::Var: return "Var";
+        case NodeKind::Unary: return "Unary";
+        case NodeKind::Binary: return "Binary";
+        case NodeKind::Call: return "Call";
+        case NodeKind::Return: return "Return";
+        case NodeKind::If: return "If";
+        case NodeKind::Let: return "Let";
+        case NodeKind::Block: return "Block";
+        case NodeKind::Function: return "Function";
+        case NodeKind::Program: return "Program";
+    }
+    return "?";
+}
+
+static const char* opName(const NodeHead& head) {
+    if (head.kind == NodeKind::Unary) return toString(static_cast<UnaryOp>(head.op));
+    return toString(static_cast<BinaryOp>(head.op));
+}
+
+void DumpWriter::quoted(std::string_view s) {
+    out.put('"');
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        const char* escape = nullptr;
+        switch (s[i]) {
+            case '\n': escape = "\\n"; break;
+            case '\t': escape = "\\t"; break;
+            case '\\': escape = "\\\\"; break;
+            case '"': escape = "\\\""; break;
+            default: continue;
+        }
+        out.write(s.substr(run, i - run));
+        out.write(escape);
+        run = i + 1;
+    }
+    out.write(s.substr(run));
+    out.put('"');
+}
+
+void DumpWriter::jsonString(std::string_view s) {
+    static constexpr char hex[] = "0123456789abcdef";
+    out.put('"');
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.write(s.substr(run, i - run));
+        run = i + 1;
+        switch (c) {
+            case '"': out.write("\\\""); break;
+            case '\\': out.write("\\\\"); break;
+            case '\n': out.write("\\n"); break;
+            case '\t': out.write("\\t"); break;
+            case '\r': out.write("\\r"); break;
+            default: {
+                char code[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                out.write({code, sizeof(code)});
+            }
+        }
+    }
+    out.write(s.substr(run));
+    out.put('"');
+}
+
+void DumpWriter::textHead(const NodeHead& head) {
+    switch (head.kind) {
+        case NodeKind::Int:
+            out.write("Int(");
+            out.writeInt(head.intValue);
+            out.write(")\n");
+            return;
+        case NodeKind::Double:
+            out.write("Double(");
+            out.writeDouble(head.doubleValue);
+            out.write(")\n");
+            return;
+        case NodeKind::String:
+            out.write("String(");
+            quoted(head.text);
+            out.write(")\n");
+            return;
+        case NodeKind::Char:
+            out.write("Char('");
+            out.put(static_cast<char>(head.intValue));
+            out.write("')\n");
+            return;
+        case NodeKind::Bool:
+            out.write(head.intValue ? "Bool(1)\n" : "Bool(0)\n");
+            return;
+        case NodeKind::Unary:
+        case NodeKind::Binary:
+            out.write(kindName(head.kind));
+            out.put('(');
+            out.write(opName(head));
+            out.write(")\n");
+            return;
+        case NodeKind::Var:
+        case NodeKind::Call:
+            out.write(kindName(head.kind));
+            out.put('(');
+            out.write(head.text);
+            out.write(")\n");
+            return;
+        case NodeKind::Let:
+            out.write("Let(");
+            out.write(head.text);
+            out.write(": ");
+            out.write(toString(head.type));
+            out.write(")\n");
+            return;
+        case NodeKind::Function:
+            out.write("Function ");
+            out.write(head.text);
+            out.write(" -> ");
+            out.write(toString(head.type));
+            out.put('\n');
+            return;
+        case NodeKind::Void:
+        case NodeKind::Return:
+        case NodeKind::If:
+        case NodeKind::Block:
+        case NodeKind::Program:
+            out.write(kindName(head.kind));
+            out.put('\n');
+            return;
+    }
+}
+
+void DumpWriter::jsonHead(const NodeHead& head) {
+    out.write("{\"kind\":\"");
+    out.write(kindName(head.kind));
+    out.put('"');
+    switch (head.kind) {
+        case NodeKind::Int:
+            out.write(",\"value\":");
+            out.writeInt(head.intValue);
+            break;
+        case NodeKind::Double:
+            out.write(",\"value\":");
+            out.writeShortestDouble(head.doubleValue);
+            break;
+        case NodeKind::String:
+            out.write(",\"value\":");
+            jsonString(head.text);
+            break;
+        case NodeKind::Char: {
+            char c = static_cast<char>(head.intValue);
+            out.write(",\"value\":");
+            jsonString({&c, 1});
+            break;
+        }
+        case NodeKind::Bool:
+            out.write(head.intValue ? ",\"value\":true" : ",\"value\":false");
+            break;
+        case NodeKind::Var:
+        case NodeKind::Let:
+            out.write(",\"name\":");
+            jsonString(head.text);
+            if (head.kind == NodeKind::Let) {
+                out.write(",\"type\":\"");
+                out.write(toString(head.type));
+                out.put('"');
+            }
+            break;
+        case NodeKind::Unary:
+        case NodeKind::Binary:
+            out.write(",\"op\":");
+            jsonString(opName(head));
+            break;
+        case NodeKind::Call:
+            out.write(",\"callee\":");
+            jsonString(head.text);
+            break;
+        case NodeKind::Function:
+            out.write(",\"name\":");
+            jsonString(head.text);
+            out.write(",\"returnType\":\"");
+            out.write(toString(head.type));
+            out.write("\",\"params\":[");
+            break;
+        case NodeKind::Void:
+        case NodeKind::Return:
+        case NodeKind::If:
+        case NodeKind::Block:
+        case NodeKind::Program:
+            break;
+    }
+    if (isLeaf(head.kind)) out.put('}');
+}
+
+void DumpWriter::sexprHead(const NodeHead& head) {
+    switch (head.kind) {
+        case NodeKind::Int:
+            out.writeInt(head.intValue);
+            return;
+        case NodeKind::Double:
+            out.writeShortestDouble(head.doubleValue);
+            return;
+        case NodeKind::String:
+            quoted(head.text);
+            return;
+        case NodeKind::Char: {
+            char c = static_cast<char>(head.intValue);
+            out.put('\'');
+            if (c == '\n') out.write("\\n");
+            else if (c == '\t') out.write("\\t");
+            else if (c == '\\' || c == '\'') {
+                out.put('\\');
+                out.put(c);
+            } else {
+                out.put(c);
+            }
+            out.put('\'');
+            return;
+        }
+        case NodeKind::Bool:
+            out.write(head.intValue ? "true" : "false");
+            return;
+        case NodeKind::Void:
+            out.write("void");
+            return;
+        case NodeKind::Var:
+            out.write(head.text);
+            return;
+        case NodeKind::Unary:
+        case NodeKind::Binary:
+            out.put('(');
+            out.write(opName(head));
+            return;
+        case NodeKind::Call:
+            out.write("(call ");
+            out.write(head.text);
+            return;
+        case NodeKind::Let:
+            out.write("(let ");
+            out.write(head.text);
+            out.put(' ');
+            out.write(toString(head.type));
+            return;
+        case NodeKind::Function:
+            out.write("(fn ");
+            out.write(head.text);
+            out.write(" (");
+            return;
+        case NodeKind::Return:
+            out.write("(return");
+            return;
+        case NodeKind::If:
+            out.write("(if");
+            return;
+        case NodeKind::Block:
+            out.write("(block");
+            return;
+        case NodeKind::Program:
+            out.write("(program");
+            return;
+    }
+}
+
+void DumpWriter::head(const NodeHead& head, int indent, bool first, bool root) {
+    switch (format) {
+        case DumpFormat::Text:
+            out.pad(indent);
+            textHead(head);
+            break;
+        case DumpFormat::Json:
+            if (!first) out.put(',');
+            jsonHead(head);
+            break;
+        case DumpFormat::Sexpr:
+            if (!root) out.put(' ');
+            sexprHead(head);
+            break;
+    }
+}
+
+void DumpWriter::param(std::string_view name, VarType type, int indent, uint32_t index) {
+    switch (format) {
+        case DumpFormat::Text:
+            out.pad(indent);
+            out.write("Param: ");
+            out.write(name);
+            out.write(": ");
+            out.write(toString(type));
+            out.put('\n');
+            break;
+        case DumpFormat::Json:
+            out.write(index ? ",{\"name\":" : "{\"name\":");
+            jsonString(name);
+            out.write(",\"type\":\"");
+            out.write(toString(type));
+            out.write("\"}");
+            break;
+        case DumpFormat::Sexpr:
+            out.write(index ? " (" : "(");
+            out.write(name);
+            out.put(' ');
+            out.write(toString(type));
+            out.put(')');
+            break;
+    }
+}
+
+void DumpWriter::endParams(const NodeHead& head) {
+    if (format == DumpFormat::Json) {
+        out.put(']');
+    } else if (format == DumpFormat::Sexpr) {
+        out.write(") ");
+        out.write(toString(head.type));
+    }
+}
+
+void DumpWriter::nullChild(bool first, bool root) {
+    if (format == DumpFormat::Json) {
+        out.write(first ? "null" : ",null");
+    } else if (format == DumpFormat::Sexpr) {
+        out.write(root ? "nil" : " nil");
+    }
+}
+
+void DumpWriter::field(const char* key) {
+    if (format != DumpFormat::Json) return;
+    out.write(",\"");
+    out.write(key);
+    out.write("\":");
+}
+
+void DumpWriter::openList(const char* key, const char* label, bool wrap, int indent) {
+    switch (format) {
+        case DumpFormat::Text:
+            if (!label) return;
+            out.pad(indent);
+            out.write(label);
+            out.put('\n');
+            break;
+        case DumpFormat::Json:
+            field(key);
+            out.put('[');
+            break;
+        case DumpFormat::Sexpr:
+            if (!wrap) return;
+            out.write(" (");
+            out.write(key);
+            break;
+    }
+}
+
+void DumpWriter::closeList(bool wrap) {
+    if (format == DumpFormat::Json) out.put(']');
+    else if (format == DumpFormat::Sexpr && wrap) out.put(')');
+}
+
+void DumpWriter::close() {
+    if (format == DumpFormat::Json) out.put('}');
+    else if (format == DumpFormat::Sexpr) out.put(')');
+}
+
+void DumpWriter::finish() {
+    if (format != DumpFormat::Text) out.put('\n');
+}
+
+namespace {
+
+struct TreeList {
+    const ASTPtr* nodes = nullptr;
+    Function* const* functions = nullptr;
+};
+
+using TreeField = DumpField<const ASTNode*, TreeList>;
+
+class TreeDescriber : public AstVisitor<TreeDescriber, int> {
+public:
+    TreeDescriber(NodeHead& h, TreeField* f) : head(h), fields(f) {}
+
+    int visitInt(const IntExpr& n) {
+        head.intValue = n.value;
+        return 0;
+    }
+
+    int visitDouble(const DoubleExpr& n) {
+        head.doubleValue = n.value;
+        return 0;
+    }
+
+    int visitString(const StringExpr& n) {
+        head.text = n.value;
+        return 0;
+    }
+
+    int visitChar(const CharExpr& n) {
+        head.intValue = n.value;
+        return 0;
+    }
+
+    int visitBool(const BoolExpr& n) {
+        head.intValue = n.value;
+        return 0;
+    }
+
+    int visitVar(const VarExpr& n) {
+        head.text = n.name.str();
+        return 0;
+    }
+
+    int visitUnary(const UnaryExpr& n) {
+        head.op = static_cast<uint8_t>(n.op);
+        fields[0] = TreeField::node("operand", n.operand);
+        return 1;
+    }
+
+    int visitBinary(const BinaryExpr& n) {
+        head.op = static_cast<uint8_t>(n.op);
+        fields[0] = TreeField::node("left", n.left);
+        fields[1] = TreeField::node("right", n.right);
+        return 2;
+    }
+
+    int visitCall(const CallExpr& n) {
+        head.text = n.callee.str();
+        fields[0] = nodes("args", n.args);
+        return 1;
+    }
+
+    int visitReturn(const ReturnStmt& n) {
+        fields[0] = TreeField::node("value", n.value);
+        return 1;
+    }
+
+    int visitIf(const IfStmt& n) {
+        fields[0] = TreeField::node("cond", n.cond);
+        fields[1] = nodes("then", n.thenBranch, "Then:", true);
+        fields[2] = nodes("else", n.elseBranch, n.elseBranch.empty() ? nullptr : "Else:", true);
+        return 3;
+    }
+
+    int visitLet(const LetDecl& n) {
+        head.text = n.name.str();
+        head.type = n.type;
+        fields[0] = TreeField::node("init", n.init);
+        return 1;
+    }
+
+    int visitBlock(const BlockStmt& n) {
+        fields[0] = nodes("statements", n.statements);
+        return 1;
+    }
+
+    int visitFunction(const Function& n) {
+        head.text = n.name.str();
+        head.type = n.returnType;
+        head.paramCount = n.params.count;
+        fields[0] = TreeField::node("body", n.body);
+        return 1;
+    }
+
+    int visitProgram(const Program& n) {
+        fields[0] = TreeField::list("functions", {nullptr, n.functions.data()},
+                                    static_cast<uint32_t>(n.functions.size()));
+        return 1;
+    }
+
+    int visitNode(const ASTNode&) { return 0; }
+
+private:
+    NodeHead& head;
+    TreeField* fields;
+
+    static TreeField nodes(const char* key, const ASTList& list, const char* label = nullptr, bool wrap = false) {
+        return TreeField::list(key, {list.items, nullptr}, list.count, label, wrap);
+    }
+};
+
+struct TreeView {
+    using Ref = const ASTNode*;
+    using Field = TreeField;
+
+    static bool isNull(Ref n) { return n == nullptr; }
+
+    static Ref item(const TreeList& list, uint32_t i) {
+        return list.nodes ? list.nodes[i] : list.functions[i];
+    }
+
+    int describe(Ref node, NodeHead& head, Field* fields) const {
+        head.kind = node->kind;
+        return TreeDescriber(head, fields).visit(*node);
+    }
+
+    void param(Ref node, uint32_t i, std::string_view& name, VarType& type) const {
+        const Param& p = static_cast<const Function*>(node)->params[i];
+        name = p.name.str();
+        type = p.type;
+    }
+};
+
+}
+
+void dumpTree(const ASTNode& root, OutputSink& sink, DumpFormat format, int indent) {
+    dumpWith(TreeView{}, &root, sink, format, indent);
+}
+
+ProgramDumpStream::ProgramDumpStream(OutputSink& sink, DumpFormat format) : out(sink, format) {
+    NodeHead head;
+    head.kind = NodeKind::Program;
+    out.head(head, 0, true, true);
+    out.openList("functions", nullptr, false, 0);
+}
+
+void ProgramDumpStream::add(const Function& fn) {
+    dumpSubtree(TreeView{}, &fn, out, 2, count++ == 0, false);
+}
+
+void ProgramDumpStream::finish() {
+    out.closeList(false);
+    out.close();
+    out.finish();
+}
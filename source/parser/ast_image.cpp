@@ -0,0 +1,223 @@
+#include "ast_image.hpp"
+#include "flat_dump.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+static constexpr char magic[4] = {'E', 'S', 'A', 'I'};
+static constexpr uint32_t byteOrderMark = 0x01020304;
+
+static_assert(sizeof(AstImage::Header) == 96, "AstImage::Header layout changed");
+static_assert(sizeof(AstImage::Node) == 16, "AstImage::Node layout changed");
+
+static uint64_t alignUp(uint64_t n) {
+    return (n + 7) & ~uint64_t(7);
+}
+
+static void put(std::string& out, uint64_t at, const void* data, size_t bytes) {
+    if (bytes) std::memcpy(&out[at], data, bytes);
+}
+
+std::string AstImage::encode(const FlatAst& ast) {
+    std::vector<Node> nodeTable(ast.nodeCount());
+    for (Index n = 0; n < nodeTable.size(); n++)
+        nodeTable[n] = {ast.kind(n), {0, 0, 0}, ast.a(n), ast.b(n), ast.c(n)};
+
+    const std::vector<Index>& listTable = ast.extra;
+    const std::vector<uint64_t>& literalTable = ast.literals;
+
+    std::vector<String> stringTable(ast.names.size());
+    uint64_t stringBytes = 0;
+    for (Index i = 0; i < stringTable.size(); i++) {
+        stringTable[i] = {static_cast<uint32_t>(stringBytes), static_cast<uint32_t>(ast.name(i).size())};
+        stringBytes += ast.name(i).size();
+        if (stringBytes > UINT32_MAX) throw std::length_error("AST image string table exceeds 4 GiB");
+    }
+
+    std::vector<FunctionEntry> functionTable;
+    if (ast.root() != FlatAst::none) {
+        Index list = ast.a(ast.root());
+        const Index* items = ast.listItems(list);
+        for (uint32_t i = 0; i < ast.listSize(list); i++) functionTable.push_back({ast.a(items[i]), items[i]});
+    }
+    std::stable_sort(functionTable.begin(), functionTable.end(), [&ast](const FunctionEntry& x, const FunctionEntry& y) {
+        return ast.name(x.name) < ast.name(y.name);
+    });
+
+    Header h{};
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version = formatVersion;
+    h.byteOrder = byteOrderMark;
+    h.root = ast.root();
+    h.nodeCount = static_cast<uint32_t>(nodeTable.size());
+    h.listWords = static_cast<uint32_t>(listTable.size());
+    h.literalCount = static_cast<uint32_t>(literalTable.size());
+    h.stringCount = static_cast<uint32_t>(stringTable.size());
+    h.functionCount = static_cast<uint32_t>(functionTable.size());
+    h.stringBytes = static_cast<uint32_t>(stringBytes);
+    h.nodes = sizeof(Header);
+    h.lists = h.nodes + nodeTable.size() * sizeof(Node);
+    h.literals = alignUp(h.lists + listTable.size() * sizeof(Index));
+    h.strings = h.literals + literalTable.size() * sizeof(uint64_t);
+    h.stringData = h.strings + stringTable.size() * sizeof(String);
+    h.functions = alignUp(h.stringData + stringBytes);
+    h.size = h.functions + functionTable.size() * sizeof(FunctionEntry);
+
+    std::string out(h.size, '\0');
+    put(out, 0, &h, sizeof(h));
+    put(out, h.nodes, nodeTable.data(), nodeTable.size() * sizeof(Node));
+    put(out, h.lists, listTable.data(), listTable.size() * sizeof(Index));
+    put(out, h.literals, literalTable.data(), literalTable.size() * sizeof(uint64_t));
+    put(out, h.strings, stringTable.data(), stringTable.size() * sizeof(String));
+    for (Index i = 0; i < stringTable.size(); i++)
+        put(out, h.stringData + stringTable[i].offset, ast.name(i).data(), stringTable[i].length);
+    put(out, h.functions, functionTable.data(), functionTable.size() * sizeof(FunctionEntry));
+    return out;
+}
+
+bool AstImage::isImage(std::string_view bytes) {
+    return bytes.size() >= sizeof(magic) && std::memcmp(bytes.data(), magic, sizeof(magic)) == 0;
+}
+
+bool AstImage::open(const std::string& path) {
+    return file.open(path) && attach(file.text());
+}
+
+static bool fits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t size) {
+    return offset % 8 == 0 && offset <= size && count <= (size - offset) / elementSize;
+}
+
+bool AstImage::attach(std::string_view bytes) {
+    header = nullptr;
+    if (bytes.size() < sizeof(Header) || reinterpret_cast<uintptr_t>(bytes.data()) % 8 != 0) return false;
+
+    auto h = reinterpret_cast<const Header*>(bytes.data());
+    if (std::memcmp(h->magic, magic, sizeof(magic)) != 0 || h->version != formatVersion ||
+        h->byteOrder != byteOrderMark || h->size != bytes.size())
+        return false;
+    if (!fits(h->nodes, h->nodeCount, sizeof(Node), h->size) ||
+        !fits(h->lists, h->listWords, sizeof(Index), h->size) ||
+        !fits(h->literals, h->literalCount, sizeof(uint64_t), h->size) ||
+        !fits(h->strings, h->stringCount, sizeof(String), h->size) ||
+        !fits(h->stringData, h->stringBytes, 1, h->size) ||
+        !fits(h->functions, h->functionCount, sizeof(FunctionEntry), h->size))
+        return false;
+    if (h->root >= h->nodeCount) return false;
+
+    const char* base = bytes.data();
+    header = h;
+    nodes = reinterpret_cast<const Node*>(base + h->nodes);
+    lists = reinterpret_cast<const Index*>(base + h->lists);
+    literals = reinterpret_cast<const uint64_t*>(base + h->literals);
+    strings = reinterpret_cast<const String*>(base + h->strings);
+    stringData = base + h->stringData;
+    functions = reinterpret_cast<const FunctionEntry*>(base + h->functions);
+    return true;
+}
+
+bool AstImage::validList(Index list) const {
+    return list < header->listWords && lists[list] <= header->listWords - list - 1;
+}
+
+bool AstImage::validChild(Index child, Index parent) const {
+    return child == none || child < parent;
+}
+
+bool AstImage::requiredChild(Index child, Index parent) const {
+    return child < parent;
+}
+
+bool AstImage::validNodeList(Index list, Index parent) const {
+    if (!validList(list)) return false;
+    const Index* items = listItems(list);
+    for (uint32_t i = 0; i < listSize(list); i++)
+        if (items[i] >= parent) return false;
+    return true;
+}
+
+static bool validType(uint32_t type) {
+    return type <= static_cast<uint32_t>(VarType::Void);
+}
+
+bool AstImage::verify() const {
+    if (!header) return false;
+    for (Index i = 0; i < header->stringCount; i++)
+        if (uint64_t(strings[i].offset) + strings[i].length > header->stringBytes) return false;
+
+    Index stringCount = header->stringCount;
+    for (Index n = 0; n < header->nodeCount; n++) {
+        const Node& node = nodes[n];
+        bool ok = false;
+        switch (node.kind) {
+            case NodeKind::Int:
+            case NodeKind::Double:
+                ok = node.a < header->literalCount;
+                break;
+            case NodeKind::String:
+            case NodeKind::Var:
+                ok = node.a < stringCount;
+                break;
+            case NodeKind::Char:
+            case NodeKind::Bool:
+            case NodeKind::Void:
+                ok = true;
+                break;
+            case NodeKind::Unary:
+                ok = node.a <= static_cast<Index>(UnaryOp::Not) && requiredChild(node.b, n);
+                break;
+            case NodeKind::Binary:
+                ok = node.a <= static_cast<Index>(BinaryOp::Div) && requiredChild(node.b, n) && requiredChild(node.c, n);
+                break;
+            case NodeKind::Call:
+                ok = node.a < stringCount && validNodeList(node.b, n);
+                break;
+            case NodeKind::Return:
+                ok = validChild(node.a, n);
+                break;
+            case NodeKind::If:
+                ok = requiredChild(node.a, n) && validNodeList(node.b, n) && validNodeList(node.c, n);
+                break;
+            case NodeKind::Let:
+                ok = node.a < stringCount && validChild(node.b, n) && validType(node.c);
+                break;
+            case NodeKind::Block:
+            case NodeKind::Program:
+                ok = validNodeList(node.a, n);
+                break;
+            case NodeKind::Function: {
+                ok = node.a < stringCount && requiredChild(node.c, n) && kind(node.c) == NodeKind::Block &&
+                     validList(node.b) && listSize(node.b) % 2 == 1 && validType(listItems(node.b)[0]);
+                const Index* sig = listItems(node.b);
+                for (uint32_t i = 1; ok && i < listSize(node.b); i += 2)
+                    ok = sig[i] < stringCount && validType(sig[i + 1]);
+                break;
+            }
+        }
+        if (!ok) return false;
+    }
+    if (kind(root()) != NodeKind::Program) return false;
+
+    for (Index i = 0; i < header->functionCount; i++) {
+        const FunctionEntry& fn = functions[i];
+        if (fn.name >= stringCount || fn.node >= header->nodeCount || kind(fn.node) != NodeKind::Function)
+            return false;
+    }
+    return true;
+}
+
+AstImage::Index AstImage::findFunction(std::string_view target) const {
+    const FunctionEntry* first = functions;
+    const FunctionEntry* last = functions + header->functionCount;
+    Index stringCount = header->stringCount;
+    auto entryName = [this, stringCount](const FunctionEntry& fn) {
+        return fn.name < stringCount ? name(fn.name) : std::string_view();
+    };
+    auto it = std::partition_point(first, last, [&](const FunctionEntry& fn) { return entryName(fn) < target; });
+    if (it == last || entryName(*it) != target || it->node >= header->nodeCount) return none;
+    return it->node;
+}
+
+void AstImage::dump(OutputSink& out, DumpFormat format) const {
+    dumpFlat(*this, root(), out, format);
+}
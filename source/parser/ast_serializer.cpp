@@ -0,0 +1,412 @@
+#include "ast_serializer.hpp"
+#include "ast_visitor.hpp"
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+static constexpr char magic[4] = {'E', 'S', 'A', 'S'};
+static constexpr uint8_t nullTag = 0xFF;
+static constexpr uint32_t unresolved = UINT32_MAX;
+
+namespace {
+
+class Writer : public AstVisitor<Writer> {
+public:
+    explicit Writer(const Program& p) : program(p) {}
+
+    std::string finish() {
+        writeNodes();
+        std::string out(magic, sizeof(magic));
+        putFixed(out, astFormatVersion, 4);
+        putVarint(out, names.size());
+        for (std::string_view s : names) {
+            putVarint(out, s.size());
+            out.append(s);
+        }
+        out += body;
+        return out;
+    }
+
+    void visitNull() { byte(nullTag); }
+
+    VisitAction leave(const ASTNode& node) {
+        emit(&node);
+        return VisitAction::Continue;
+    }
+
+private:
+    const Program& program;
+    std::string body;
+    size_t nextFunction = 0;
+    std::vector<std::string_view> names;
+    std::unordered_map<std::string_view, uint64_t> nameIds;
+
+    static void putVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    static void putFixed(std::string& out, uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; i++) out.push_back(static_cast<char>(v >> (8 * i)));
+    }
+
+    void tag(NodeKind kind) { body.push_back(static_cast<char>(kind)); }
+    void byte(uint8_t b) { body.push_back(static_cast<char>(b)); }
+    void varint(uint64_t v) { putVarint(body, v); }
+
+    void name(std::string_view s) {
+        auto it = nameIds.find(s);
+        if (it == nameIds.end()) {
+            it = nameIds.emplace(s, names.size()).first;
+            names.push_back(s);
+        }
+        varint(it->second);
+    }
+
+    void name(Symbol s) { name(s.str()); }
+
+    void emit(const ASTNode* node) {
+        tag(node->kind);
+        varint(node->kind == NodeKind::Function ? program.functionOffset(nextFunction++) : node->offset);
+        switch (node->kind) {
+            case NodeKind::Int: {
+                int64_t v = static_cast<const IntExpr*>(node)->value;
+                varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+                break;
+            }
+            case NodeKind::Double: {
+                uint64_t bits;
+                std::memcpy(&bits, &static_cast<const DoubleExpr*>(node)->value, sizeof(bits));
+                putFixed(body, bits, 8);
+                break;
+            }
+            case NodeKind::String:
+                name(static_cast<const StringExpr*>(node)->value);
+                break;
+            case NodeKind::Char:
+                byte(static_cast<uint8_t>(static_cast<const CharExpr*>(node)->value));
+                break;
+            case NodeKind::Bool:
+                byte(static_cast<const BoolExpr*>(node)->value);
+                break;
+            case NodeKind::Void:
+            case NodeKind::Return:
+                break;
+            case NodeKind::Var:
+                name(static_cast<const VarExpr*>(node)->name);
+                break;
+            case NodeKind::Unary:
+                byte(static_cast<uint8_t>(static_cast<const UnaryExpr*>(node)->op));
+                break;
+            case NodeKind::Binary:
+                byte(static_cast<uint8_t>(static_cast<const BinaryExpr*>(node)->op));
+                break;
+            case NodeKind::Call: {
+                auto n = static_cast<const CallExpr*>(node);
+                name(n->callee);
+                varint(n->args.size());
+                break;
+            }
+            case NodeKind::If: {
+                auto n = static_cast<const IfStmt*>(node);
+                varint(n->thenBranch.size());
+                varint(n->elseBranch.size());
+                break;
+            }
+            case NodeKind::Let: {
+                auto n = static_cast<const LetDecl*>(node);
+                name(n->name);
+                byte(static_cast<uint8_t>(n->type));
+                break;
+            }
+            case NodeKind::Block:
+                varint(static_cast<const BlockStmt*>(node)->statements.size());
+                break;
+            case NodeKind::Function: {
+                auto n = static_cast<const Function*>(node);
+                name(n->name);
+                byte(static_cast<uint8_t>(n->returnType));
+                varint(n->params.size());
+                for (const auto& p : n->params) {
+                    name(p.name);
+                    byte(static_cast<uint8_t>(p.type));
+                    varint(p.offset);
+                }
+                break;
+            }
+            case NodeKind::Program:
+                varint(static_cast<const Program*>(node)->functions.size());
+                break;
+        }
+    }
+
+    void writeNodes() { traverse(program); }
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view bytes)
+        : p(bytes.data()), end(bytes.data() + bytes.size()) {}
+
+    std::unique_ptr<Program> read() {
+        if (!header()) return nullptr;
+        auto prog = std::make_unique<Program>();
+        arena = &prog->arena();
+
+        uint64_t count = varint();
+        if (count > static_cast<uint64_t>(end - p)) return nullptr;
+        names.reserve(count);
+        for (uint64_t i = 0; i < count && ok; i++) {
+            uint64_t len = varint();
+            if (len > static_cast<uint64_t>(end - p)) return nullptr;
+            names.push_back(arena->copy({p, len}));
+            p += len;
+        }
+
+        while (ok && p < end) {
+            uint8_t t = byte();
+            if (t == static_cast<uint8_t>(NodeKind::Program)) {
+                if (!readProgram(*prog)) return nullptr;
+                return p == end && stack.empty() ? std::move(prog) : nullptr;
+            }
+            if (!readNode(t)) return nullptr;
+        }
+        return nullptr;
+    }
+
+private:
+    const char* p;
+    const char* end;
+    bool ok = true;
+    AstArena* arena = nullptr;
+    std::vector<std::string_view> names;
+    std::vector<Symbol> symbols;
+    std::vector<ASTPtr> stack;
+
+    bool header() {
+        if (end - p < 8 || std::memcmp(p, magic, sizeof(magic)) != 0) return false;
+        p += sizeof(magic);
+        return fixed(4) == astFormatVersion;
+    }
+
+    uint8_t byte() {
+        if (p == end) {
+            ok = false;
+            return 0;
+        }
+        return static_cast<uint8_t>(*p++);
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    uint64_t fixed(int bytes) {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) v |= static_cast<uint64_t>(byte()) << (8 * i);
+        return v;
+    }
+
+    std::string_view name() {
+        uint64_t id = varint();
+        if (id >= names.size()) {
+            ok = false;
+            return {};
+        }
+        return names[id];
+    }
+
+    Symbol symbol() {
+        uint64_t id = varint();
+        if (id >= names.size()) {
+            ok = false;
+            return {};
+        }
+        if (symbols.size() < names.size()) symbols.resize(names.size(), Symbol{unresolved});
+        if (symbols[id].id == unresolved) symbols[id] = intern(names[id]);
+        return symbols[id];
+    }
+
+    VarType type() {
+        uint8_t t = byte();
+        if (t > static_cast<uint8_t>(VarType::Void)) ok = false;
+        return static_cast<VarType>(t);
+    }
+
+    bool pop(ASTPtr& out) {
+        if (stack.empty()) return ok = false;
+        out = stack.back();
+        stack.pop_back();
+        return true;
+    }
+
+    // Only a Let initializer and a Return value may be null; everything
+    // else has to be a node of a kind the parser puts in that slot.
+    bool popExpr(ASTPtr& out, bool optional = false) {
+        if (!pop(out)) return false;
+        if (out ? out->kind <= NodeKind::Call : optional) return true;
+        return ok = false;
+    }
+
+    bool popList(uint64_t count, ASTList& out, NodeKind last) {
+        if (count > stack.size()) return ok = false;
+        std::vector<ASTPtr> items(stack.end() - count, stack.end());
+        stack.resize(stack.size() - count);
+        for (ASTPtr item : items)
+            if (!item || item->kind > last) return ok = false;
+        out = arena->list(items);
+        return true;
+    }
+
+    uint32_t offset() {
+        uint64_t v = varint();
+        if (v > UINT32_MAX) ok = false;
+        return static_cast<uint32_t>(v);
+    }
+
+    bool readNode(uint8_t t) {
+        ASTPtr node = nullptr;
+        bool function = t == static_cast<uint8_t>(NodeKind::Function);
+        uint64_t at = t == nullTag ? 0 : function ? varint() : offset();
+        switch (t) {
+            case nullTag:
+                break;
+            case static_cast<uint8_t>(NodeKind::Int): {
+                uint64_t z = varint();
+                node = arena->make<IntExpr>(static_cast<int64_t>((z >> 1) ^ (~(z & 1) + 1)));
+                break;
+            }
+            case static_cast<uint8_t>(NodeKind::Double): {
+                uint64_t bits = fixed(8);
+                double v;
+                std::memcpy(&v, &bits, sizeof(v));
+                node = arena->make<DoubleExpr>(v);
+                break;
+            }
+            case static_cast<uint8_t>(NodeKind::String):
+                node = arena->make<StringExpr>(name());
+                break;
+            case static_cast<uint8_t>(NodeKind::Char):
+                node = arena->make<CharExpr>(static_cast<char>(byte()));
+                break;
+            case static_cast<uint8_t>(NodeKind::Bool):
+                node = arena->make<BoolExpr>(byte() != 0);
+                break;
+            case static_cast<uint8_t>(NodeKind::Void):
+                node = arena->make<VoidExpr>();
+                break;
+            case static_cast<uint8_t>(NodeKind::Var):
+                node = arena->make<VarExpr>(symbol());
+                break;
+            case static_cast<uint8_t>(NodeKind::Unary): {
+                uint8_t op = byte();
+                ASTPtr operand;
+                if (op > static_cast<uint8_t>(UnaryOp::Not) || !popExpr(operand)) return false;
+                node = arena->make<UnaryExpr>(static_cast<UnaryOp>(op), operand);
+                break;
+            }
+            case static_cast<uint8_t>(NodeKind::Binary): {
+                uint8_t op = byte();
+                ASTPtr left, right;
+                if (op > static_cast<uint8_t>(BinaryOp::Div) || !popExpr(right) || !popExpr(left)) return false;
+                node = arena->make<BinaryExpr>(static_cast<BinaryOp>(op), left, right);
+                break;
+            }
+            case static_cast<uint8_t>(NodeKind::Call): {
+                Symbol callee = symbol();
+                ASTList args;
+                if (!popList(varint(), args, NodeKind::Call)) return false;
+                node = arena->make<CallExpr>(callee, args);
+                break;
+            }
+            case static_cast<uint8_t>(NodeKind::Return): {
+                ASTPtr value;
+                if (!popExpr(value, true)) return false;
+                node = arena->make<ReturnStmt>(value);
+                break;
+            }
+            case static_cast<uint8_t>(NodeKind::If): {
+                uint64_t thenCount = varint();
+                uint64_t elseCount = varint();
+                ASTList thenBranch, elseBranch;
+                ASTPtr cond;
+                if (!popList(elseCount, elseBranch, NodeKind::Block) ||
+                    !popList(thenCount, thenBranch, NodeKind::Block) || !popExpr(cond))
+                    return false;
+                node = arena->make<IfStmt>(cond, thenBranch, elseBranch);
+                break;
+            }
+            case static_cast<uint8_t>(NodeKind::Let): {
+                Symbol n = symbol();
+                VarType vt = type();
+                ASTPtr init;
+                if (!popExpr(init, true)) return false;
+                node = arena->make<LetDecl>(n, vt, init);
+                break;
+            }
+            case static_cast<uint8_t>(NodeKind::Block): {
+                ASTList statements;
+                if (!popList(varint(), statements, NodeKind::Block)) return false;
+                node = arena->make<BlockStmt>(statements);
+                break;
+            }
+            case static_cast<uint8_t>(NodeKind::Function): {
+                Symbol n = symbol();
+                VarType rt = type();
+                uint64_t count = varint();
+                if (count > static_cast<uint64_t>(end - p)) return ok = false;
+                std::vector<Param> params;
+                params.reserve(count);
+                for (uint64_t i = 0; i < count && ok; i++) {
+                    Symbol pname = symbol();
+                    VarType ptype = type();
+                    params.push_back({pname, ptype, offset()});
+                }
+                ASTPtr body;
+                if (!pop(body) || !body || body->kind != NodeKind::Block) return ok = false;
+                node = arena->make<Function>(n, rt, arena->list(params), static_cast<BlockStmt*>(body));
+                break;
+            }
+            default:
+                return ok = false;
+        }
+        if (node && function) static_cast<Function*>(node)->start = static_cast<size_t>(at);
+        else if (node) node->offset = static_cast<uint32_t>(at);
+        stack.push_back(node);
+        return ok;
+    }
+
+    bool readProgram(Program& prog) {
+        offset();
+        uint64_t count = varint();
+        if (!ok || count > stack.size()) return false;
+        prog.functions.resize(count);
+        for (uint64_t i = count; i-- > 0;) {
+            ASTPtr fn = stack.back();
+            stack.pop_back();
+            if (!fn || fn->kind != NodeKind::Function) return false;
+            prog.functions[i] = static_cast<Function*>(fn);
+        }
+        return true;
+    }
+};
+
+}
+
+std::string serializeProgram(const Program& program) {
+    return Writer(program).finish();
+}
+
+std::unique_ptr<Program> deserializeProgram(std::string_view bytes) {
+    return Reader(bytes).read();
+}
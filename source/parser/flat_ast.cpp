@@ -0,0 +1,179 @@
+#include "flat_ast.hpp"
+#include "ast_visitor.hpp"
+#include "flat_dump.hpp"
+#include <cstring>
+
+FlatAst::Index FlatAst::addNode(NodeKind kind, Index a, Index b, Index c) {
+    kinds.push_back(kind);
+    fieldA.push_back(a);
+    fieldB.push_back(b);
+    fieldC.push_back(c);
+    return static_cast<Index>(kinds.size() - 1);
+}
+
+FlatAst::Index FlatAst::intern(std::string_view s) {
+    auto it = nameIds.find(s);
+    if (it != nameIds.end()) return it->second;
+    std::string_view stored = nameStorage.copy(s);
+    Index id = static_cast<Index>(names.size());
+    names.push_back(stored);
+    nameIds.emplace(stored, id);
+    return id;
+}
+
+FlatAst::Index FlatAst::intern(Symbol s) {
+    auto it = symbolIds.find(s);
+    if (it != symbolIds.end()) return it->second;
+    Index id = intern(s.str());
+    symbolIds.emplace(s, id);
+    return id;
+}
+
+FlatAst::Index FlatAst::addLiteral(uint64_t bits) {
+    literals.push_back(bits);
+    return static_cast<Index>(literals.size() - 1);
+}
+
+FlatAst::Index FlatAst::addList(const std::vector<Index>& items) {
+    Index list = static_cast<Index>(extra.size());
+    extra.push_back(static_cast<Index>(items.size()));
+    extra.insert(extra.end(), items.begin(), items.end());
+    return list;
+}
+
+size_t FlatAst::bytes() const {
+    return kinds.capacity() * sizeof(NodeKind) +
+           (fieldA.capacity() + fieldB.capacity() + fieldC.capacity() + extra.capacity()) * sizeof(Index) +
+           literals.capacity() * sizeof(uint64_t) +
+           names.capacity() * sizeof(std::string_view) +
+           nameStorage.bytesReserved();
+}
+
+class FlatAstBuilder : public AstVisitor<FlatAstBuilder, FlatAst::Index> {
+public:
+    explicit FlatAstBuilder(FlatAst& out) : ast(out) {}
+
+    FlatAst::Index build(const ASTNode& root) {
+        traverse(root);
+        return results.back();
+    }
+
+    void visitNull() { results.push_back(FlatAst::none); }
+
+    VisitAction leave(const ASTNode& node) {
+        results.push_back(visit(node));
+        return VisitAction::Continue;
+    }
+
+    FlatAst::Index visitInt(const IntExpr& n) {
+        return ast.addNode(NodeKind::Int, ast.addLiteral(static_cast<uint64_t>(n.value)));
+    }
+
+    FlatAst::Index visitDouble(const DoubleExpr& n) {
+        uint64_t bits;
+        std::memcpy(&bits, &n.value, sizeof(bits));
+        return ast.addNode(NodeKind::Double, ast.addLiteral(bits));
+    }
+
+    FlatAst::Index visitString(const StringExpr& n) {
+        return ast.addNode(NodeKind::String, ast.intern(n.value));
+    }
+
+    FlatAst::Index visitChar(const CharExpr& n) {
+        return ast.addNode(NodeKind::Char, static_cast<unsigned char>(n.value));
+    }
+
+    FlatAst::Index visitBool(const BoolExpr& n) {
+        return ast.addNode(NodeKind::Bool, n.value);
+    }
+
+    FlatAst::Index visitVoid(const VoidExpr&) {
+        return ast.addNode(NodeKind::Void);
+    }
+
+    FlatAst::Index visitVar(const VarExpr& n) {
+        return ast.addNode(NodeKind::Var, ast.intern(n.name));
+    }
+
+    FlatAst::Index visitUnary(const UnaryExpr& n) {
+        FlatAst::Index operand = pop();
+        return ast.addNode(NodeKind::Unary, static_cast<FlatAst::Index>(n.op), operand);
+    }
+
+    FlatAst::Index visitBinary(const BinaryExpr& n) {
+        FlatAst::Index right = pop();
+        FlatAst::Index left = pop();
+        return ast.addNode(NodeKind::Binary, static_cast<FlatAst::Index>(n.op), left, right);
+    }
+
+    FlatAst::Index visitCall(const CallExpr& n) {
+        FlatAst::Index args = popList(n.args.size());
+        return ast.addNode(NodeKind::Call, ast.intern(n.callee), args);
+    }
+
+    FlatAst::Index visitReturn(const ReturnStmt&) {
+        return ast.addNode(NodeKind::Return, pop());
+    }
+
+    FlatAst::Index visitIf(const IfStmt& n) {
+        FlatAst::Index elseList = popList(n.elseBranch.size());
+        FlatAst::Index thenList = popList(n.thenBranch.size());
+        FlatAst::Index cond = pop();
+        return ast.addNode(NodeKind::If, cond, thenList, elseList);
+    }
+
+    FlatAst::Index visitLet(const LetDecl& n) {
+        FlatAst::Index init = pop();
+        return ast.addNode(NodeKind::Let, ast.intern(n.name), init, static_cast<FlatAst::Index>(n.type));
+    }
+
+    FlatAst::Index visitBlock(const BlockStmt& n) {
+        return ast.addNode(NodeKind::Block, popList(n.statements.size()));
+    }
+
+    FlatAst::Index visitFunction(const Function& n) {
+        FlatAst::Index body = pop();
+        std::vector<FlatAst::Index> sig;
+        sig.push_back(static_cast<FlatAst::Index>(n.returnType));
+        for (const auto& p : n.params) {
+            sig.push_back(ast.intern(p.name));
+            sig.push_back(static_cast<FlatAst::Index>(p.type));
+        }
+        return ast.addNode(NodeKind::Function, ast.intern(n.name), ast.addList(sig), body);
+    }
+
+    FlatAst::Index visitProgram(const Program& n) {
+        return ast.addNode(NodeKind::Program, popList(n.functions.size()));
+    }
+
+private:
+    FlatAst& ast;
+    std::vector<FlatAst::Index> results;
+
+    FlatAst::Index pop() {
+        FlatAst::Index top = results.back();
+        results.pop_back();
+        return top;
+    }
+
+    FlatAst::Index popList(size_t count) {
+        std::vector<FlatAst::Index> items(results.end() - count, results.end());
+        results.resize(results.size() - count);
+        return ast.addList(items);
+    }
+};
+
+FlatAst FlatAst::fromTree(const Program& program) {
+    FlatAst ast;
+    size_t estimate = program.nodeCount() + 1;
+    ast.kinds.reserve(estimate);
+    ast.fieldA.reserve(estimate);
+    ast.fieldB.reserve(estimate);
+    ast.fieldC.reserve(estimate);
+    ast.rootIndex = FlatAstBuilder(ast).build(program);
+    return ast;
+}
+
+void FlatAst::dump(OutputSink& out, DumpFormat format) const {
+    if (rootIndex != none) dumpFlat(*this, rootIndex, out, format);
+}
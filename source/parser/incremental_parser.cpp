@@ -0,0 +1,121 @@
+#include "incremental_parser.hpp"
+#include "item_splitter.hpp"
+#include "parallel_parser.hpp"
+#include <algorithm>
+
+static std::vector<SourceSpan> resplit(const Program& program, size_t firstOld, const TextEdit& edit,
+                                       std::string_view text, size_t begin, size_t& resume) {
+    std::vector<SourceSpan> spans;
+    ItemSplitter splitter;
+    size_t itemBegin = begin;
+    size_t pos = begin;
+    size_t j = firstOld;
+    size_t count = program.items.size();
+    resume = count;
+
+    while (splitter.next(text, pos, true)) {
+        spans.push_back({itemBegin, pos});
+        itemBegin = pos;
+        if (pos < edit.offset + edit.inserted) continue;
+        while (j < count && program.item(j).span.end + edit.inserted < pos + edit.removed) j++;
+        if (j < count && program.item(j).span.end + edit.inserted == pos + edit.removed) {
+            resume = j + 1;
+            return spans;
+        }
+    }
+    if (itemBegin < text.size()) spans.push_back({itemBegin, text.size()});
+    return spans;
+}
+
+template <typename T>
+static void splice(std::vector<T>& target, size_t at, size_t count, std::vector<T>& replacement) {
+    size_t common = std::min(count, replacement.size());
+    std::move(replacement.begin(), replacement.begin() + common, target.begin() + at);
+    if (count > common) {
+        target.erase(target.begin() + at + common, target.begin() + at + count);
+    } else {
+        target.insert(target.begin() + at + common, std::make_move_iterator(replacement.begin() + common),
+                      std::make_move_iterator(replacement.end()));
+    }
+}
+
+std::unique_ptr<Program> reparse(std::unique_ptr<Program> program, const TextEdit& edit,
+                                 std::string_view newText, std::vector<Diagnostic>& diagnostics,
+                                 unsigned maxNesting) {
+    if (!program || program->items.empty()) return parseParallel(newText, 1, diagnostics, maxNesting);
+
+    Program& prog = *program;
+    const ProgramItem* base = prog.items.data();
+    size_t count = prog.items.size();
+    size_t editEnd = edit.offset + edit.removed;
+    auto first = std::partition_point(prog.items.begin(), prog.items.end(), [&](const ProgramItem& item) {
+        return prog.item(static_cast<size_t>(&item - base)).span.end <= edit.offset;
+    });
+    auto last = std::partition_point(first, prog.items.end(), [&](const ProgramItem& item) {
+        return prog.item(static_cast<size_t>(&item - base)).span.begin < editEnd;
+    });
+    size_t a = std::min(static_cast<size_t>(first - prog.items.begin()), count - 1);
+    size_t b = std::max(static_cast<size_t>(last - prog.items.begin()), a + 1);
+
+    size_t begin = prog.item(a).span.begin;
+    size_t resume = 0;
+    std::vector<SourceSpan> spans = resplit(prog, b - 1, edit, newText, begin, resume);
+
+    size_t firstFunction = prog.item(a).firstFunction;
+    size_t firstDiagnostic = prog.item(a).firstDiagnostic;
+    size_t removedFunctions = 0;
+    size_t removedDiagnostics = 0;
+    for (size_t i = a; i < resume; i++) {
+        removedFunctions += prog.items[i].functionCount;
+        removedDiagnostics += prog.items[i].diagnosticCount;
+        prog.discardedBytes += prog.items[i].bytes;
+    }
+
+    AstArena& arena = *prog.arenas.back();
+    std::vector<Function*> functions;
+    std::vector<Diagnostic> errors;
+    std::vector<ProgramItem> fresh;
+    fresh.reserve(spans.size());
+    for (const SourceSpan& span : spans) {
+        fresh.push_back(parseItem(newText, span, arena, functions, errors, maxNesting));
+        fresh.back().firstFunction += static_cast<uint32_t>(firstFunction);
+        fresh.back().firstDiagnostic += static_cast<uint32_t>(firstDiagnostic);
+    }
+
+    if (prog.discardedBytes > prog.bytesUsed() - prog.discardedBytes + AstArena::slabSize) {
+        program.reset();
+        return parseParallel(newText, 1, diagnostics, maxNesting);
+    }
+
+    size_t addedDiagnostics = errors.size();
+    ItemShift delta{0, edit.inserted - edit.removed,
+                    static_cast<uint32_t>(functions.size() - removedFunctions),
+                    static_cast<uint32_t>(addedDiagnostics - removedDiagnostics)};
+    ItemShift& pending = prog.pendingShift;
+    if (pending.offset == 0 && pending.functions == 0 && pending.diagnostics == 0) pending.from = resume;
+    if (pending.from < a) prog.settleItems(a);
+    if (pending.from > resume) {
+        for (size_t i = resume; i < pending.from; i++) {
+            ProgramItem& item = prog.items[i];
+            item.span.begin += delta.offset;
+            item.span.end += delta.offset;
+            item.firstFunction += delta.functions;
+            item.firstDiagnostic += delta.diagnostics;
+        }
+    } else {
+        pending.from = resume;
+    }
+    pending.from = pending.from + spans.size() - (resume - a);
+    pending.offset += delta.offset;
+    pending.functions += delta.functions;
+    pending.diagnostics += delta.diagnostics;
+
+    splice(prog.functions, firstFunction, removedFunctions, functions);
+    splice(prog.diagnostics, firstDiagnostic, removedDiagnostics, errors);
+    splice(prog.items, a, resume - a, fresh);
+    for (size_t i = firstDiagnostic + addedDiagnostics; i < prog.diagnostics.size(); i++)
+        prog.diagnostics[i].offset += delta.offset;
+
+    diagnostics.insert(diagnostics.end(), prog.diagnostics.begin(), prog.diagnostics.end());
+    return program;
+}
@@ -0,0 +1,87 @@
+#include "item_splitter.hpp"
+#include "scan.hpp"
+
+void ItemSplitter::reset() {
+    state = State::Code;
+    depth = 0;
+    escape = false;
+}
+
+bool ItemSplitter::next(std::string_view text, size_t& pos, bool atEof) {
+    const char* base = text.data();
+    const char* end = base + text.size();
+
+    while (pos < text.size()) {
+        char c = text[pos];
+        switch (state) {
+            case State::Code:
+                if (c == '/') {
+                    if (pos + 1 == text.size() && !atEof) return false;
+                    char n = pos + 1 < text.size() ? text[pos + 1] : '\0';
+                    if (n == '/') { state = State::LineComment; pos += 2; continue; }
+                    if (n == '*') { state = State::BlockComment; pos += 2; continue; }
+                } else if (c == '"') {
+                    state = State::String;
+                } else if (c == '\'') {
+                    state = State::Char;
+                } else if (c == '{') {
+                    depth++;
+                } else if (c == '}') {
+                    pos++;
+                    if (depth <= 1) {
+                        depth = 0;
+                        return true;
+                    }
+                    depth--;
+                    continue;
+                }
+                pos++;
+                break;
+
+            case State::LineComment: {
+                const char* nl = scan::findByte(base + pos, end, '\n');
+                pos = static_cast<size_t>(nl - base);
+                if (nl != end) state = State::Code;
+                break;
+            }
+
+            case State::BlockComment: {
+                const char* close = scan::findCommentEnd(base + pos, end);
+                if (close == end) {
+                    pos = text.size();
+                    if (!atEof && text.back() == '*') pos--;
+                    return false;
+                }
+                pos = static_cast<size_t>(close - base) + 2;
+                state = State::Code;
+                break;
+            }
+
+            case State::String:
+            case State::Char:
+                if (escape) {
+                    escape = false;
+                } else if (c == '\\') {
+                    escape = true;
+                } else if (c == (state == State::String ? '"' : '\'')) {
+                    state = State::Code;
+                }
+                pos++;
+                break;
+        }
+    }
+    return false;
+}
+
+std::vector<SourceSpan> splitTopLevelItems(std::string_view text) {
+    std::vector<SourceSpan> spans;
+    ItemSplitter splitter;
+    size_t begin = 0;
+    size_t pos = 0;
+    while (splitter.next(text, pos, true)) {
+        spans.push_back({begin, pos});
+        begin = pos;
+    }
+    if (begin < text.size()) spans.push_back({begin, text.size()});
+    return spans;
+}
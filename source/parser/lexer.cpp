@@ -1,10 +1,18 @@
 #include "lexer.hpp"
-#include <cctype>
+#include "charclass.hpp"
+#include "keywords.hpp"
+#include "scan.hpp"
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
 #include <stdexcept>
-#include <unordered_map>
 
-Lexer::Lexer(const std::string &src)
-    : source(src), length(src.size()), pos(0), line(1), col(1) {}
+Lexer::Lexer(std::string_view src, int first)
+    : source(src), length(src.size()), pos(0), firstLine(first) {}
+
+Lexer::Lexer(std::string_view src, size_t begin, size_t end, int first, int column)
+    : source(src), length(end), pos(begin), firstLine(first), firstColumn(column) {}
 
 char Lexer::peek(size_t offset) const {
     if (pos + offset >= length) return '\0';
@@ -13,19 +21,29 @@ char Lexer::peek(size_t offset) const {
 
 char Lexer::advance() {
     if (pos >= length) return '\0';
-    char c = source[pos++];
-
-    if (c == '\n') {
-        line++;
-        col = 1;
-    } else if (c == '\t') {
-        int tabSize = 4;
-        col += tabSize - ((col - 1) % tabSize);
-    } else {
-        col++;
-    }
+    return source[pos++];
+}
 
-    return c;
+std::string_view Lexer::text(size_t start) const {
+    return source.substr(start, pos - start);
+}
+
+Token Lexer::makeToken(TokenType type, size_t start) const {
+    return {type, text(start), start};
+}
+
+Token Lexer::errorToken(const char* message, size_t start, size_t at) const {
+    Token tok{TokenType::Error, text(start), at};
+    tok.errorMessage = message;
+    return tok;
+}
+
+static const char* const unexpectedCharacter = "Unexpected character";
+
+std::string Lexer::describeError(const Token& tok) {
+    std::string message = tok.errorMessage;
+    if (tok.errorMessage == unexpectedCharacter) message += ": " + std::string(tok.lexeme);
+    return message;
 }
 
 bool Lexer::match(char expected) {
@@ -36,209 +54,224 @@ bool Lexer::match(char expected) {
     return false;
 }
 
-void Lexer::skipWhitespaceAndComments() {
+bool Lexer::skipWhitespaceAndComments() {
+    const char* start = source.data();
+    const char* end = start + length;
+    const char* p = start + pos;
+
     while (true) {
-        char c = peek();
-        if (std::isspace(c)) {
-            advance();
-        } else if (c == '/' && peek(1) == '/') {
-            while (peek() != '\n' && peek() != '\0') advance();
-        } else if (c == '/' && peek(1) == '*') {
-            advance(); advance();
-            while (!(peek() == '*' && peek(1) == '/')) {
-                if (peek() == '\0')
-                    throw error("Unterminated block comment");
-                advance();
+        p = scan::skipSpace(p, end);
+        if (end - p < 2 || p[0] != '/') break;
+        if (p[1] == '/') {
+            p = scan::findByte(p + 2, end, '\n');
+        } else if (p[1] == '*') {
+            const char* close = scan::findCommentEnd(p + 2, end);
+            if (close == end) {
+                pos = static_cast<size_t>(p - start);
+                return false;
             }
-            advance(); advance();
+            p = close + 2;
         } else {
             break;
         }
     }
+    pos = static_cast<size_t>(p - start);
+    return true;
 }
 
 Token Lexer::identifierOrKeyword() {
     size_t startPos = pos;
-    int startCol = col, startLine = line;
-    while (std::isalnum(peek()) || peek() == '_') advance();
-    std::string text = source.substr(startPos, pos - startPos);
-
-    static const std::unordered_map<std::string, TokenType> keywords = {
-        {"fn", TokenType::Fn}, {"let", TokenType::Let},
-        {"if", TokenType::If}, {"else", TokenType::Else},
-        {"return", TokenType::Return}, {"print", TokenType::Print},
-
-        {"Int", TokenType::IntType},
-        {"Float", TokenType::FloatType},
-        {"String", TokenType::StringType},
-        {"Char", TokenType::CharType},
-        {"Bool", TokenType::BoolType},
-        {"Void", TokenType::VoidType},
-
-        {"true", TokenType::Bool},
-        {"false", TokenType::Bool},
-    };
+    while (isIdentContinue(peek())) advance();
+    std::string_view word = text(startPos);
 
+    Token tok{keywordType(word), word, startPos};
+    if (tok.type == TokenType::Bool) tok.boolValue = word == "true";
+    else if (tok.type == TokenType::Identifier) tok.symbol = intern(word);
+    return tok;
+}
 
-    auto it = keywords.find(text);
-    if (it != keywords.end())
-        return {it->second, text, startLine, startCol};
-    return {TokenType::Identifier, text, startLine, startCol};
+// Floating-point from_chars is missing from older standard libraries,
+// notably Apple's libc++; the lexeme is then copied so strtod can see a
+// terminator. Nothing calls setlocale, so strtod expects a '.' as well.
+static bool parseFloat(const char* first, const char* last, double& out) {
+#if defined(__cpp_lib_to_chars)
+    return std::from_chars(first, last, out).ec == std::errc();
+#else
+    std::string text(first, last);
+    errno = 0;
+    out = std::strtod(text.c_str(), nullptr);
+    return errno != ERANGE;
+#endif
 }
 
 Token Lexer::number() {
     size_t startPos = pos;
-    int startCol = col, startLine = line;
     bool isFloat = false;
 
-    while (std::isdigit(peek())) advance();
-    if (peek() == '.' && std::isdigit(peek(1))) {
+    while (isDigit(peek())) advance();
+    if (peek() == '.' && isDigit(peek(1))) {
         isFloat = true;
         advance();
-        while (std::isdigit(peek())) advance();
+        while (isDigit(peek())) advance();
     }
 
-    std::string num = source.substr(startPos, pos - startPos);
-    return {isFloat ? TokenType::Float : TokenType::Integer, num, startLine, startCol};
+    Token tok = makeToken(isFloat ? TokenType::Float : TokenType::Integer, startPos);
+    const char* first = tok.lexeme.data();
+    const char* last = first + tok.lexeme.size();
+    bool ok = isFloat ? parseFloat(first, last, tok.floatValue)
+                      : std::from_chars(first, last, tok.intValue).ec == std::errc();
+    if (!ok) return errorToken("Numeric literal out of range", startPos, startPos);
+    return tok;
+}
+
+static bool decodeEscape(char e, char quote, char &out) {
+    switch (e) {
+        case 'n': out = '\n'; return true;
+        case 't': out = '\t'; return true;
+        case '\\': out = '\\'; return true;
+    }
+    out = e;
+    return e == quote;
+}
+
+std::string_view Lexer::unescape(std::string_view body) {
+    char* out = strings.allocateChars(body.size());
+    size_t n = 0;
+    for (size_t i = 0; i < body.size(); i++) {
+        char c = body[i];
+        if (c == '\\') decodeEscape(body[++i], '"', c);
+        out[n++] = c;
+    }
+    return {out, n};
 }
 
 Token Lexer::string() {
-    int startCol = col, startLine = line;
     size_t startPos = pos - 1;
+    bool escaped = false;
+    size_t badEscape = 0;
 
-    advance();
-
-    std::string value;
     while (true) {
         char c = advance();
-        if (c == '\0') throw error("Unterminated string");
+        if (c == '\0') return errorToken("Unterminated string", startPos, startPos);
         if (c == '"') break;
         if (c == '\\') {
-            char e = advance();
-            switch (e) {
-                case 'n': value.push_back('\n'); break;
-                case 't': value.push_back('\t'); break;
-                case '\\': value.push_back('\\'); break;
-                case '"': value.push_back('"'); break;
-                default: throw error("Invalid escape sequence");
-            }
-        } else {
-            value.push_back(c);
+            char decoded;
+            if (!decodeEscape(advance(), '"', decoded) && !badEscape) badEscape = pos - 1;
+            escaped = true;
         }
     }
+    if (badEscape) return errorToken("Invalid escape sequence", startPos, badEscape);
 
-    size_t endPos = pos;
-    std::string lexeme = source.substr(startPos, endPos - startPos);
-
-    return {TokenType::String, lexeme, startLine, startCol};
+    Token tok = makeToken(TokenType::String, startPos);
+    std::string_view body = tok.lexeme.substr(1, tok.lexeme.size() - 2);
+    tok.stringValue = escaped ? unescape(body) : body;
+    return tok;
 }
 
 Token Lexer::_char() {
-    int startCol = col, startLine = line;
+    size_t startPos = pos - 1;
     char c = advance();
-    if (c == '\0') throw error("Unterminated char literal");
-
-    char value;
-
-    if (c == '\\') {
-        char e = advance();
-        switch (e) {
-            case 'n': value = '\n'; break;
-            case 't': value = '\t'; break;
-            case '\\': value = '\\'; break;
-            case '\'': value = '\''; break;
-            default: throw error("Invalid escape sequence in char literal");
-        }
-    } else {
-        value = c;
+    if (c == '\0') return errorToken("Unterminated char literal", startPos, startPos);
+
+    char value = c;
+    if (c == '\\' && !decodeEscape(advance(), '\'', value)) {
+        size_t at = pos - 1;
+        match('\'');
+        return errorToken("Invalid escape sequence in char literal", startPos, at);
     }
     if (!match('\'')) {
-        throw error("Unterminated char literal, missing closing '");
+        size_t at = pos;
+        while (peek() != '\'' && peek() != '\n' && peek() != '\0') advance();
+        match('\'');
+        return errorToken("Unterminated char literal, missing closing '", startPos, at);
     }
-    return {TokenType::Char, std::string(1, value), startLine, startCol};
+    Token tok = makeToken(TokenType::Char, startPos);
+    tok.charValue = value;
+    return tok;
 }
 
 Token Lexer::nextToken() {
-    skipWhitespaceAndComments();
-    if (pos >= length) return {TokenType::Eof, "", line, col};
+    if (lookaheadCount == 0) return lexToken();
+    Token tok = lookahead[lookaheadHead];
+    lookaheadHead = (lookaheadHead + 1) % maxLookahead;
+    lookaheadCount--;
+    return tok;
+}
 
-    char c = advance();
-    int startLine = line, startCol = col - 1;
-
-    switch (c) {
-        case '(': return {TokenType::LParen, "(", startLine, startCol};
-        case ')': return {TokenType::RParen, ")", startLine, startCol};
-        case '{': return {TokenType::LBrace, "{", startLine, startCol};
-        case '}': return {TokenType::RBrace, "}", startLine, startCol};
-        case ',': return {TokenType::Comma, ",", startLine, startCol};
-        case ':': return {TokenType::Colon, ":", startLine, startCol};
-        case ';': return {TokenType::Semi, ";", startLine, startCol};
-
-        case '+':
-            if (match('=')) return {TokenType::PlusAssign, "+=", startLine, startCol};
-            return {TokenType::Plus, "+", startLine, startCol};
-        case '-':
-            if (match('>')) return {TokenType::Arrow, "->", startLine, startCol};
-            if (match('=')) return {TokenType::MinusAssign, "-=", startLine, startCol};
-            return {TokenType::Minus, "-", startLine, startCol};
-        case '*':
-            if (match('=')) return {TokenType::StarAssign, "*=", startLine, startCol};
-            return {TokenType::Star, "*", startLine, startCol};
-        case '/':
-            if (match('=')) return {TokenType::SlashAssign, "/=", startLine, startCol};
-            return {TokenType::Slash, "/", startLine, startCol};
-
-        case '=':
-            if (match('=')) return {TokenType::EqEq, "==", startLine, startCol};
-            return {TokenType::Eq, "=", startLine, startCol};
-        case '!':
-            if (match('=')) return {TokenType::Neq, "!=", startLine, startCol};
-            return {TokenType::Bang, "!", startLine, startCol};
-        case '<':
-            if (match('=')) return {TokenType::Leq, "<=", startLine, startCol};
-            return {TokenType::Less, "<", startLine, startCol};
-        case '>':
-            if (match('=')) return {TokenType::Geq, ">=", startLine, startCol};
-            return {TokenType::Greater, ">", startLine, startCol};
-
-        case '"': return string();
-        case '\'': return _char();
+const Token& Lexer::peekToken(size_t k) {
+    if (k >= maxLookahead) throw std::out_of_range("Lookahead exceeds Lexer::maxLookahead");
+    while (lookaheadCount <= k) {
+        lookahead[(lookaheadHead + lookaheadCount) % maxLookahead] = lexToken();
+        lookaheadCount++;
     }
+    return lookahead[(lookaheadHead + k) % maxLookahead];
+}
 
-    if (std::isalpha(c) || c == '_') {
-        pos--; return identifierOrKeyword();
+Token Lexer::lexToken() {
+    if (!skipWhitespaceAndComments()) {
+        size_t startPos = pos;
+        pos = length;
+        return errorToken("Unterminated block comment", startPos, startPos);
     }
-    if (std::isdigit(c)) {
-        pos--; return number();
-    }
-
-    throw error(std::string("Unexpected character: ") + c);
-}
+    if (pos >= length) return {TokenType::Eof, text(pos), pos};
 
-Token Lexer::peekToken() {
-    size_t savedPos = pos;
-    int savedLine = line, savedCol = col;
-    Token tok = nextToken();
-    pos = savedPos; line = savedLine; col = savedCol;
-    return tok;
-}
+    size_t startPos = pos;
+    char c = advance();
 
-std::string Lexer::getCurrentLine() const {
-    if (pos == 0) return "";
+    uint8_t cls = charClass(c);
+    if (cls & CC_OperatorStart) {
+        switch (c) {
+            case '(': return makeToken(TokenType::LParen, startPos);
+            case ')': return makeToken(TokenType::RParen, startPos);
+            case '{': return makeToken(TokenType::LBrace, startPos);
+            case '}': return makeToken(TokenType::RBrace, startPos);
+            case ',': return makeToken(TokenType::Comma, startPos);
+            case ':': return makeToken(TokenType::Colon, startPos);
+            case ';': return makeToken(TokenType::Semi, startPos);
+
+            case '+':
+                if (match('=')) return makeToken(TokenType::PlusAssign, startPos);
+                return makeToken(TokenType::Plus, startPos);
+            case '-':
+                if (match('>')) return makeToken(TokenType::Arrow, startPos);
+                if (match('=')) return makeToken(TokenType::MinusAssign, startPos);
+                return makeToken(TokenType::Minus, startPos);
+            case '*':
+                if (match('=')) return makeToken(TokenType::StarAssign, startPos);
+                return makeToken(TokenType::Star, startPos);
+            case '/':
+                if (match('=')) return makeToken(TokenType::SlashAssign, startPos);
+                return makeToken(TokenType::Slash, startPos);
+
+            case '=':
+                if (match('=')) return makeToken(TokenType::EqEq, startPos);
+                return makeToken(TokenType::Eq, startPos);
+            case '!':
+                if (match('=')) return makeToken(TokenType::Neq, startPos);
+                return makeToken(TokenType::Bang, startPos);
+            case '<':
+                if (match('=')) return makeToken(TokenType::Leq, startPos);
+                return makeToken(TokenType::Less, startPos);
+            case '>':
+                if (match('=')) return makeToken(TokenType::Geq, startPos);
+                return makeToken(TokenType::Greater, startPos);
+
+            case '"': return string();
+            case '\'': return _char();
+        }
+    }
 
-    size_t lineStart = pos - 1;
-    while (lineStart > 0 && source[lineStart - 1] != '\n') {
-        lineStart--;
+    if (cls & CC_IdentStart) {
+        pos--; return identifierOrKeyword();
     }
-    size_t lineEnd = lineStart;
-    while (lineEnd < length && source[lineEnd] != '\n') {
-        lineEnd++;
+    if (cls & CC_Digit) {
+        pos--; return number();
     }
-    return source.substr(lineStart, lineEnd - lineStart);
+
+    return errorToken(unexpectedCharacter, startPos, startPos);
 }
 
-LexerError Lexer::error(const std::string &msg) const {
-    std::string lineText = getCurrentLine();
-    int errorCol = (col > 1) ? col - 1 : 1;
-    return LexerError(msg, line, errorCol, lineText);
+const SourceManager& Lexer::sourceManager() const {
+    if (!lines) lines = std::make_unique<SourceManager>(source, firstLine, firstColumn);
+    return *lines;
 }
@@ -0,0 +1,61 @@
+#include "parallel_parser.hpp"
+#include "item_splitter.hpp"
+#include "parser.hpp"
+#include "thread_pool.hpp"
+
+ProgramItem parseItem(std::string_view source, SourceSpan span, AstArena& arena,
+                      std::vector<Function*>& out, std::vector<Diagnostic>& diagnostics,
+                      unsigned maxNesting) {
+    size_t before = arena.bytesUsed();
+    size_t first = out.size();
+    Lexer lexer(source, span.begin, span.end);
+    Parser parser(lexer);
+    parser.setMaxNesting(maxNesting);
+    parser.parseInto(arena, out);
+    for (size_t i = first; i < out.size(); i++)
+        out[i]->start -= span.begin;
+
+    ProgramItem item;
+    item.span = span;
+    item.firstFunction = static_cast<uint32_t>(first);
+    item.functionCount = static_cast<uint32_t>(out.size() - first);
+    item.firstDiagnostic = static_cast<uint32_t>(diagnostics.size());
+    item.diagnosticCount = static_cast<uint32_t>(parser.diagnostics().size());
+    item.bytes = arena.bytesUsed() - before;
+    diagnostics.insert(diagnostics.end(), parser.diagnostics().begin(), parser.diagnostics().end());
+    return item;
+}
+
+std::unique_ptr<Program> parseParallel(std::string_view source, unsigned jobs,
+                                       std::vector<Diagnostic>& diagnostics,
+                                       unsigned maxNesting) {
+    std::vector<SourceSpan> spans = splitTopLevelItems(source);
+
+    std::vector<std::unique_ptr<AstArena>> arenas(jobs);
+    for (auto& a : arenas) a = std::make_unique<AstArena>();
+    std::vector<std::vector<Function*>> results(spans.size());
+    std::vector<std::vector<Diagnostic>> errors(spans.size());
+    std::vector<ProgramItem> items(spans.size());
+
+    parallelFor(spans.size(), jobs, 64, [&](size_t i, unsigned worker) {
+        items[i] = parseItem(source, spans[i], *arenas[worker], results[i], errors[i], maxNesting);
+    });
+
+    auto prog = std::make_unique<Program>();
+    for (size_t i = 0; i < items.size(); i++) {
+        items[i].firstDiagnostic = static_cast<uint32_t>(prog->diagnostics.size());
+        prog->diagnostics.insert(prog->diagnostics.end(), errors[i].begin(), errors[i].end());
+    }
+    diagnostics.insert(diagnostics.end(), prog->diagnostics.begin(), prog->diagnostics.end());
+    prog->items = std::move(items);
+    size_t total = 0;
+    for (const auto& r : results) total += r.size();
+    prog->functions.reserve(total);
+    for (size_t i = 0; i < results.size(); i++) {
+        prog->items[i].firstFunction = static_cast<uint32_t>(prog->functions.size());
+        prog->functions.insert(prog->functions.end(), results[i].begin(), results[i].end());
+    }
+    for (auto& a : arenas)
+        if (a->nodeCount() > 0) prog->adopt(std::move(a));
+    return prog;
+}
@@ -1,14 +1,75 @@
 #include "parser.hpp"
-#include <stdexcept>
+#include <algorithm>
+#include <array>
+
+static VarType tokenToVarType(TokenType t) {
+    switch (t) {
+        case TokenType::IntType: return VarType::Int;
+        case TokenType::FloatType: return VarType::Float;
+        case TokenType::StringType: return VarType::String;
+        case TokenType::CharType: return VarType::Char;
+        case TokenType::BoolType: return VarType::Bool;
+        default: return VarType::Void;
+    }
+}
+
+namespace {
+
+struct OperatorInfo {
+    int precedence = 0;
+    bool rightAssoc = false;
+    BinaryOp op = BinaryOp::Assign;
+};
+
+constexpr size_t tokenTypeCount = static_cast<size_t>(TokenType::Eof) + 1;
+
+constexpr std::array<OperatorInfo, tokenTypeCount> makeOperatorTable() {
+    std::array<OperatorInfo, tokenTypeCount> table{};
+    auto set = [&table](TokenType t, int prec, bool right, BinaryOp op) {
+        table[static_cast<size_t>(t)] = {prec, right, op};
+    };
+    set(TokenType::Eq, 1, true, BinaryOp::Assign);
+    set(TokenType::PlusAssign, 1, true, BinaryOp::AddAssign);
+    set(TokenType::MinusAssign, 1, true, BinaryOp::SubAssign);
+    set(TokenType::StarAssign, 1, true, BinaryOp::MulAssign);
+    set(TokenType::SlashAssign, 1, true, BinaryOp::DivAssign);
+    set(TokenType::EqEq, 2, false, BinaryOp::Eq);
+    set(TokenType::Neq, 2, false, BinaryOp::Neq);
+    set(TokenType::Less, 3, false, BinaryOp::Less);
+    set(TokenType::Greater, 3, false, BinaryOp::Greater);
+    set(TokenType::Leq, 3, false, BinaryOp::Leq);
+    set(TokenType::Geq, 3, false, BinaryOp::Geq);
+    set(TokenType::Plus, 4, false, BinaryOp::Add);
+    set(TokenType::Minus, 4, false, BinaryOp::Sub);
+    set(TokenType::Star, 5, false, BinaryOp::Mul);
+    set(TokenType::Slash, 5, false, BinaryOp::Div);
+    return table;
+}
+
+constexpr auto operatorTable = makeOperatorTable();
+
+static_assert(operatorTable[static_cast<size_t>(TokenType::Star)].precedence >
+              operatorTable[static_cast<size_t>(TokenType::Plus)].precedence);
+static_assert(operatorTable[static_cast<size_t>(TokenType::Eq)].rightAssoc);
+
+struct PendingOp {
+    enum Kind : uint8_t { Binary, Unary, Group };
+    Kind kind;
+    OperatorInfo info;
+    UnaryOp unary = UnaryOp::Neg;
+    size_t offset = 0;
+};
+
+class NestingScope {
+public:
+    explicit NestingScope(unsigned& d) : depth(d), saved(d) {}
+    ~NestingScope() { depth = saved; }
+
+private:
+    unsigned& depth;
+    unsigned saved;
+};
 
-static VarType stringToVarType(const std::string& s) {
-    if (s == "Int") return VarType::Int;
-    if (s == "Float") return VarType::Float;
-    if (s == "String") return VarType::String;
-    if (s == "Char") return VarType::Char;
-    if (s == "Bool") return VarType::Bool;
-    if (s == "Void") return VarType::Void;
-    throw std::runtime_error("Unknown type: " + s);
 }
 
 bool Parser::isTypeToken(TokenType t) const {
@@ -26,7 +87,22 @@ bool Parser::isTypeToken(TokenType t) const {
 }
 
 void Parser::advance() {
-    current = lexer.nextToken();
+    while (true) {
+        if (!tokens) {
+            current = lexer->nextToken();
+        } else {
+            current = tokens->token(index);
+            if (index + 1 < tokens->size()) index++;
+        }
+        if (current.type != TokenType::Error) return;
+        diags.push_back({DiagnosticStage::Lexer, Lexer::describeError(current), current.offset});
+        panicking = true;
+    }
+}
+
+Token Parser::peek(size_t k) {
+    if (!tokens) return lexer->peekToken(k);
+    return tokens->token(std::min(index + k, tokens->size() - 1));
 }
 
 bool Parser::check(TokenType type) const {
@@ -41,203 +117,295 @@ bool Parser::match(TokenType type) {
     return false;
 }
 
-void Parser::expect(TokenType type, const std::string &msg) {
-    if (!match(type)) throw std::runtime_error("Expected " + msg);
+bool Parser::expect(TokenType type, const char *what) {
+    if (match(type)) return true;
+    error(std::string("Expected ") + what);
+    return false;
+}
+
+void Parser::error(std::string msg) {
+    if (panicking) return;
+    diags.push_back({DiagnosticStage::Parser, std::move(msg), current.offset});
+    panicking = true;
+}
+
+bool Parser::nest() {
+    if (++depth <= maxNesting) return true;
+    error("Nesting exceeds the limit of " + std::to_string(maxNesting) + " levels");
+    return false;
+}
+
+void Parser::synchronize() {
+    while (!check(TokenType::Eof) && !check(TokenType::RBrace) && !check(TokenType::Fn)) {
+        if (match(TokenType::Semi)) return;
+        advance();
+    }
 }
 
 std::unique_ptr<Program> Parser::parseProgram() {
     auto prog = std::make_unique<Program>();
+    parseInto(prog->arena(), prog->functions);
+    return prog;
+}
+
+void Parser::parseInto(AstArena &target, std::vector<Function*> &out) {
+    arena = &target;
     while (!check(TokenType::Eof)) {
-        prog->functions.push_back(std::unique_ptr<Function>(static_cast<Function*>(parseFunction().release())));
+        panicking = false;
+        if (Function* fn = parseFunction()) {
+            out.push_back(fn);
+            continue;
+        }
+        while (!check(TokenType::Eof) && !check(TokenType::Fn)) advance();
     }
-    return prog;
+    arena = nullptr;
 }
 
-ASTPtr Parser::parseFunction() {
-    expect(TokenType::Fn, "`fn`");
-    if (!check(TokenType::Identifier)) throw std::runtime_error("Expected function name");
-    std::string name = current.lexeme;
+Function* Parser::parseFunction() {
+    if (!expect(TokenType::Fn, "`fn`")) return nullptr;
+    if (!check(TokenType::Identifier)) {
+        error("Expected function name");
+        return nullptr;
+    }
+    Symbol name = current.symbol;
+    functionStart = current.offset;
     advance();
 
-    expect(TokenType::LParen, "`(`");
-    std::vector<std::pair<std::string, VarType>> params;
+    if (!expect(TokenType::LParen, "`(`")) return nullptr;
+    std::vector<Param> params;
     if (!check(TokenType::RParen)) {
         do {
-            if (!check(TokenType::Identifier)) throw std::runtime_error("Expected parameter name");
-            std::string pname = current.lexeme;
+            if (!check(TokenType::Identifier)) {
+                error("Expected parameter name");
+                return nullptr;
+            }
+            Symbol pname = current.symbol;
+            size_t poffset = current.offset;
             advance();
-            expect(TokenType::Colon, "`:`");
-            if (!isTypeToken(current.type)) throw std::runtime_error("Expected parameter type");
-            VarType ptype = stringToVarType(current.lexeme);
+            if (!expect(TokenType::Colon, "`:`")) return nullptr;
+            if (!isTypeToken(current.type)) {
+                error("Expected parameter type");
+                return nullptr;
+            }
+            VarType ptype = tokenToVarType(current.type);
             advance();
-            params.push_back({pname, ptype});
+            params.push_back({pname, ptype, static_cast<uint32_t>(poffset - functionStart)});
         } while (match(TokenType::Comma));
     }
-    expect(TokenType::RParen, "`)`");
-    expect(TokenType::Arrow, "`->`");
-    if (!isTypeToken(current.type)) throw std::runtime_error("Expected return type");
-    VarType returnType = stringToVarType(current.lexeme);
+    if (!expect(TokenType::RParen, "`)`")) return nullptr;
+    if (!expect(TokenType::Arrow, "`->`")) return nullptr;
+    if (!isTypeToken(current.type)) {
+        error("Expected return type");
+        return nullptr;
+    }
+    VarType returnType = tokenToVarType(current.type);
     advance();
 
-    auto stmts = parseBlock();
-    auto body = std::make_unique<BlockStmt>(std::move(stmts));
-
-    auto fn = std::make_unique<Function>(name, returnType, std::move(params), std::move(body));
+    size_t bodyOffset = current.offset;
+    ASTList stmts;
+    if (!parseBlock(stmts)) return nullptr;
+    auto body = make<BlockStmt>(bodyOffset, stmts);
+    auto fn = arena->make<Function>(name, returnType, arena->list(params), body);
+    fn->start = functionStart;
     return fn;
 }
 
-std::vector<ASTPtr> Parser::parseBlock() {
-    expect(TokenType::LBrace, "`{`");
+bool Parser::parseBlock(ASTList &out) {
+    NestingScope scope(depth);
+    if (!check(TokenType::LBrace)) {
+        error("Expected `{`");
+        return false;
+    }
+    if (!nest()) return false;
+    advance();
     std::vector<ASTPtr> stmts;
-    while (!check(TokenType::RBrace) && !check(TokenType::Eof)) {
-        stmts.push_back(parseStatement());
+    while (!check(TokenType::RBrace) && !check(TokenType::Eof) && !check(TokenType::Fn)) {
+        panicking = false;
+        if (ASTPtr stmt = parseStatement()) stmts.push_back(stmt);
+        else synchronize();
     }
-    expect(TokenType::RBrace, "`}`");
-    return stmts;
+    if (!expect(TokenType::RBrace, "`}`")) return false;
+    out = arena->list(stmts);
+    return true;
 }
 
 ASTPtr Parser::parseStatement() {
     ASTPtr stmt;
+    size_t offset = current.offset;
 
     if (match(TokenType::Let)) stmt = parseLetDecl();
-    else if (match(TokenType::If)) stmt = parseIfStmt();
-    else if (match(TokenType::Return)) stmt = parseReturnStmt();
+    else if (match(TokenType::If)) stmt = parseIfStmt(offset);
+    else if (match(TokenType::Return)) stmt = parseReturnStmt(offset);
     else stmt = parseExpression();
 
-    if (!check(TokenType::RBrace)) {
-        expect(TokenType::Semi, "`;` after statement");
-    }
+    if (!stmt) return nullptr;
+    if (!check(TokenType::RBrace) && !expect(TokenType::Semi, "`;` after statement")) return nullptr;
     return stmt;
 }
 
 ASTPtr Parser::parseLetDecl() {
-    if (!check(TokenType::Identifier)) throw std::runtime_error("Expected variable name");
-    std::string name = current.lexeme;
+    if (!check(TokenType::Identifier)) {
+        error("Expected variable name");
+        return nullptr;
+    }
+    Symbol name = current.symbol;
+    size_t offset = current.offset;
     advance();
-    expect(TokenType::Colon, "`:`");
-    if (!isTypeToken(current.type)) throw std::runtime_error("Expected type name");
-    VarType type = stringToVarType(current.lexeme);
+    if (!expect(TokenType::Colon, "`:`")) return nullptr;
+    if (!isTypeToken(current.type)) {
+        error("Expected type name");
+        return nullptr;
+    }
+    VarType type = tokenToVarType(current.type);
     advance();
     ASTPtr init = nullptr;
     if (match(TokenType::Eq)) {
         init = parseExpression();
+        if (!init) return nullptr;
     }
-    return std::make_unique<LetDecl>(name, type, std::move(init));
+    return make<LetDecl>(offset, name, type, init);
 }
 
-ASTPtr Parser::parseIfStmt() {
+ASTPtr Parser::parseIfStmt(size_t offset) {
     auto cond = parseExpression();
-    auto thenBranch = parseBlock();
-    std::vector<ASTPtr> elseBranch;
-    if (match(TokenType::Else)) {
-        elseBranch = parseBlock();
-    }
-    return std::make_unique<IfStmt>(std::move(cond), std::move(thenBranch), std::move(elseBranch));
+    if (!cond) return nullptr;
+    ASTList thenBranch;
+    if (!parseBlock(thenBranch)) return nullptr;
+    ASTList elseBranch;
+    if (match(TokenType::Else) && !parseBlock(elseBranch)) return nullptr;
+    return make<IfStmt>(offset, cond, thenBranch, elseBranch);
 }
 
-ASTPtr Parser::parseReturnStmt() {
+ASTPtr Parser::parseReturnStmt(size_t offset) {
     auto value = parseExpression();
-    return std::make_unique<ReturnStmt>(std::move(value));
+    if (!value) return nullptr;
+    return make<ReturnStmt>(offset, value);
 }
 
 ASTPtr Parser::parseExpression() {
-    return parseEquality();
-}
+    NestingScope scope(depth);
+    std::vector<ASTPtr> operands;
+    std::vector<PendingOp> ops;
+    size_t groups = 0;
 
-ASTPtr Parser::parseEquality() {
-    auto expr = parseComparison();
-    while (match(TokenType::Eq)) {
-        auto right = parseComparison();
-        expr = std::make_unique<BinaryExpr>("=", std::move(expr), std::move(right));
-    }
-    return expr;
-}
+    auto reduce = [&]() {
+        PendingOp op = ops.back();
+        ops.pop_back();
+        ASTPtr right = operands.back();
+        if (op.kind == PendingOp::Unary) {
+            operands.back() = make<UnaryExpr>(op.offset, op.unary, right);
+            return;
+        }
+        operands.pop_back();
+        operands.back() = make<BinaryExpr>(op.offset, op.info.op, operands.back(), right);
+    };
+    auto bindsBefore = [&ops](const OperatorInfo& next) {
+        if (ops.empty() || ops.back().kind == PendingOp::Group) return false;
+        if (ops.back().kind == PendingOp::Unary) return true;
+        const OperatorInfo& top = ops.back().info;
+        return top.precedence > next.precedence || (top.precedence == next.precedence && !next.rightAssoc);
+    };
 
-ASTPtr Parser::parseComparison() {
-    auto expr = parseTerm();
-    while (match(TokenType::Leq)) {
-        auto right = parseTerm();
-        expr = std::make_unique<BinaryExpr>("<=", std::move(expr), std::move(right));
-    }
-    return expr;
-}
+    while (true) {
+        while (true) {
+            if (check(TokenType::Minus) || check(TokenType::Bang)) {
+                ops.push_back({PendingOp::Unary, {}, check(TokenType::Minus) ? UnaryOp::Neg : UnaryOp::Not,
+                               current.offset});
+            } else if (check(TokenType::LParen)) {
+                if (!nest()) return nullptr;
+                ops.push_back({PendingOp::Group, {}});
+                groups++;
+            } else {
+                break;
+            }
+            advance();
+        }
+
+        ASTPtr operand = parsePrimary();
+        if (!operand) return nullptr;
+        operands.push_back(operand);
 
-ASTPtr Parser::parseTerm() {
-    auto expr = parseFactor();
-    while (match(TokenType::Plus) || match(TokenType::Minus)) {
-        std::string op = current.lexeme;
-        auto right = parseFactor();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+        while (groups > 0 && check(TokenType::RParen)) {
+            while (ops.back().kind != PendingOp::Group) reduce();
+            ops.pop_back();
+            groups--;
+            depth--;
+            advance();
+        }
+
+        const OperatorInfo& info = operatorTable[static_cast<size_t>(current.type)];
+        if (info.precedence == 0) break;
+        while (bindsBefore(info)) reduce();
+        ops.push_back({PendingOp::Binary, info, UnaryOp::Neg, current.offset});
+        advance();
     }
-    return expr;
-}
 
-ASTPtr Parser::parseFactor() {
-    auto expr = parsePrimary();
-    while (match(TokenType::Star) || match(TokenType::Slash)) {
-        std::string op = current.lexeme;
-        auto right = parsePrimary();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+    if (groups > 0) {
+        depth -= static_cast<unsigned>(groups);
+        error("Expected `)`");
+        return nullptr;
     }
-    return expr;
+    while (!ops.empty()) reduce();
+    return operands.back();
 }
 
 ASTPtr Parser::parsePrimary() {
+    size_t offset = current.offset;
     if (check(TokenType::Integer)) {
-        std::string numText = current.lexeme;
+        int64_t value = current.intValue;
         advance();
-        return std::make_unique<IntExpr>(std::stoll(numText));
+        return make<IntExpr>(offset, value);
     }
     if (check(TokenType::Float)) {
-        std::string numText = current.lexeme;
+        double value = current.floatValue;
         advance();
-        return std::make_unique<DoubleExpr>(std::stof(numText));
+        return make<DoubleExpr>(offset, value);
     }
     if (check(TokenType::String)) {
-        std::string strText = current.lexeme;
+        std::string_view value = arena->copy(current.stringValue);
         advance();
-        return std::make_unique<StringExpr>(strText);
+        return make<StringExpr>(offset, value);
     }
     if (check(TokenType::Char)) {
-        std::string charText = current.lexeme;
+        char value = current.charValue;
         advance();
-        if (charText.empty()) 
-            throw std::runtime_error("Empty char literal");
-        return std::make_unique<CharExpr>(charText[0]);
+        return make<CharExpr>(offset, value);
     }
     if (check(TokenType::Bool)) {
-        bool val = (current.lexeme == "true");
+        bool value = current.boolValue;
         advance();
-        return std::make_unique<BoolExpr>(val);
+        return make<BoolExpr>(offset, value);
     }
     if (check(TokenType::Identifier)) {
         return parseCallOrVar();
     }
-    if (match(TokenType::LParen)) {
-        auto expr = parseExpression();
-        expect(TokenType::RParen, "`)`");
-        return expr;
-    }
     if (check(TokenType::VoidType)) {
         advance();
-        return std::make_unique<VoidExpr>();
+        return make<VoidExpr>(offset);
     }
 
-    throw std::runtime_error("Unexpected token in expression");
+    error("Unexpected token in expression");
+    return nullptr;
 }
 
 ASTPtr Parser::parseCallOrVar() {
-    std::string name = current.lexeme;
+    Symbol name = current.symbol;
+    size_t offset = current.offset;
     advance();
-    if (match(TokenType::LParen)) {
+    if (check(TokenType::LParen)) {
+        NestingScope scope(depth);
+        if (!nest()) return nullptr;
+        advance();
         std::vector<ASTPtr> args;
         if (!check(TokenType::RParen)) {
             do {
-                args.push_back(parseExpression());
+                ASTPtr arg = parseExpression();
+                if (!arg) return nullptr;
+                args.push_back(arg);
             } while (match(TokenType::Comma));
         }
-        expect(TokenType::RParen, "`)`");
-        return std::make_unique<CallExpr>(name, std::move(args));
+        if (!expect(TokenType::RParen, "`)`")) return nullptr;
+        return make<CallExpr>(offset, name, arena->list(args));
     }
-    return std::make_unique<VarExpr>(name);
+    return make<VarExpr>(offset, name);
 }
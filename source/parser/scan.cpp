@@ -0,0 +1,218 @@
+#include "scan.hpp"
+#include "charclass.hpp"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+    (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ESHARP_SCAN_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define ESHARP_SCAN_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace scan {
+namespace {
+
+inline unsigned lowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return idx;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+inline void pushBits(uint32_t mask, size_t base, std::vector<size_t>& out) {
+    while (mask) {
+        out.push_back(base + lowestBit(mask));
+        mask &= mask - 1;
+    }
+}
+
+const char* skipSpaceScalar(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) p++;
+    return p;
+}
+
+const char* findByteScalar(const char* p, const char* end, char c) {
+    while (p < end && *p != c) p++;
+    return p;
+}
+
+const char* findCommentEndScalar(const char* p, const char* end) {
+    while (p + 1 < end && !(p[0] == '*' && p[1] == '/')) p++;
+    return p + 1 < end ? p : end;
+}
+
+void collectNewlinesScalar(const char* begin, const char* p, const char* end, std::vector<size_t>& out) {
+    for (; p < end; p++)
+        if (*p == '\n') out.push_back(static_cast<size_t>(p - begin));
+}
+
+#ifdef ESHARP_SCAN_SSE2
+
+inline __m128i spaceMask16(__m128i v) {
+    __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+    return _mm_or_si128(ctrl, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+}
+
+const char* skipSpaceSse2(const char* p, const char* end) {
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t other = ~static_cast<uint32_t>(_mm_movemask_epi8(spaceMask16(v))) & 0xFFFFu;
+        if (other) return p + lowestBit(other);
+        p += 16;
+    }
+    return skipSpaceScalar(p, end);
+}
+
+const char* findByteSse2(const char* p, const char* end, char c) {
+    __m128i needle = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t hits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+        if (hits) return p + lowestBit(hits);
+        p += 16;
+    }
+    return findByteScalar(p, end, c);
+}
+
+const char* findCommentEndSse2(const char* p, const char* end) {
+    __m128i star = _mm_set1_epi8('*');
+    __m128i slash = _mm_set1_epi8('/');
+    while (end - p >= 17) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        __m128i both = _mm_and_si128(_mm_cmpeq_epi8(a, star), _mm_cmpeq_epi8(b, slash));
+        uint32_t hits = static_cast<uint32_t>(_mm_movemask_epi8(both));
+        if (hits) return p + lowestBit(hits);
+        p += 16;
+    }
+    return findCommentEndScalar(p, end);
+}
+
+void collectNewlinesSse2(const char* begin, const char* p, const char* end, std::vector<size_t>& out) {
+    __m128i nl = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        pushBits(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl))),
+                 static_cast<size_t>(p - begin), out);
+        p += 16;
+    }
+    collectNewlinesScalar(begin, p, end, out);
+}
+
+#endif
+
+#ifdef ESHARP_SCAN_AVX2
+
+#define ESHARP_AVX2 __attribute__((target("avx2")))
+
+ESHARP_AVX2 inline __m256i spaceMask32(__m256i v) {
+    __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+    __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    return _mm256_or_si256(ctrl, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+}
+
+ESHARP_AVX2 const char* skipSpaceAvx2(const char* p, const char* end) {
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t other = ~static_cast<uint32_t>(_mm256_movemask_epi8(spaceMask32(v)));
+        if (other) return p + lowestBit(other);
+        p += 32;
+    }
+    return skipSpaceSse2(p, end);
+}
+
+ESHARP_AVX2 const char* findByteAvx2(const char* p, const char* end, char c) {
+    __m256i needle = _mm256_set1_epi8(c);
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t hits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+        if (hits) return p + lowestBit(hits);
+        p += 32;
+    }
+    return findByteSse2(p, end, c);
+}
+
+ESHARP_AVX2 const char* findCommentEndAvx2(const char* p, const char* end) {
+    __m256i star = _mm256_set1_epi8('*');
+    __m256i slash = _mm256_set1_epi8('/');
+    while (end - p >= 33) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        __m256i both = _mm256_and_si256(_mm256_cmpeq_epi8(a, star), _mm256_cmpeq_epi8(b, slash));
+        uint32_t hits = static_cast<uint32_t>(_mm256_movemask_epi8(both));
+        if (hits) return p + lowestBit(hits);
+        p += 32;
+    }
+    return findCommentEndSse2(p, end);
+}
+
+ESHARP_AVX2 void collectNewlinesAvx2(const char* begin, const char* p, const char* end, std::vector<size_t>& out) {
+    __m256i nl = _mm256_set1_epi8('\n');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        pushBits(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl))),
+                 static_cast<size_t>(p - begin), out);
+        p += 32;
+    }
+    collectNewlinesSse2(begin, p, end, out);
+}
+
+#endif
+
+struct Dispatch {
+    const char* (*skipSpace)(const char*, const char*);
+    const char* (*findByte)(const char*, const char*, char);
+    const char* (*findCommentEnd)(const char*, const char*);
+    void (*collectNewlines)(const char*, const char*, const char*, std::vector<size_t>&);
+    const char* name;
+};
+
+Dispatch select() {
+#ifdef ESHARP_SCAN_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {skipSpaceAvx2, findByteAvx2, findCommentEndAvx2, collectNewlinesAvx2, "avx2"};
+#endif
+#ifdef ESHARP_SCAN_SSE2
+    return {skipSpaceSse2, findByteSse2, findCommentEndSse2, collectNewlinesSse2, "sse2"};
+#else
+    return {skipSpaceScalar, findByteScalar, findCommentEndScalar, collectNewlinesScalar, "scalar"};
+#endif
+}
+
+const Dispatch dispatch = select();
+
+}
+
+const char* skipSpace(const char* p, const char* end) {
+    return dispatch.skipSpace(p, end);
+}
+
+const char* findByte(const char* p, const char* end, char c) {
+    return dispatch.findByte(p, end, c);
+}
+
+const char* findCommentEnd(const char* p, const char* end) {
+    return dispatch.findCommentEnd(p, end);
+}
+
+void collectNewlines(const char* begin, const char* end, std::vector<size_t>& out) {
+    dispatch.collectNewlines(begin, begin, end, out);
+}
+
+const char* isaName() {
+    return dispatch.name;
+}
+
+}
@@ -0,0 +1,68 @@
+#include "token_buffer.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+static bool hasPayload(TokenType type) {
+    switch (type) {
+        case TokenType::Integer:
+        case TokenType::Float:
+        case TokenType::String:
+        case TokenType::Char:
+        case TokenType::Bool:
+        case TokenType::Error:
+            return true;
+        default:
+            return false;
+    }
+}
+
+TokenBuffer::TokenBuffer(Lexer& lexer) : source(lexer.sourceText()) {
+    if (source.size() > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("Source too large for a token buffer");
+
+    size_t estimate = source.size() / 4 + 1;
+    types.reserve(estimate);
+    offsets.reserve(estimate);
+    lengths.reserve(estimate);
+    symbols.reserve(estimate);
+
+    while (true) {
+        Token tok = lexer.nextToken();
+        types.push_back(tok.type);
+        offsets.push_back(static_cast<uint32_t>(tok.offset));
+        lengths.push_back(static_cast<uint32_t>(tok.lexeme.size()));
+        symbols.push_back(tok.type == TokenType::Identifier ? tok.symbol : Symbol{});
+        if (hasPayload(tok.type)) {
+            literalIndex.push_back(static_cast<uint32_t>(types.size() - 1));
+            literals.push_back(tok);
+        }
+        if (tok.type == TokenType::Eof) break;
+    }
+
+    types.shrink_to_fit();
+    offsets.shrink_to_fit();
+    lengths.shrink_to_fit();
+    symbols.shrink_to_fit();
+    literalIndex.shrink_to_fit();
+    literals.shrink_to_fit();
+}
+
+size_t TokenBuffer::bytes() const {
+    return types.capacity() * sizeof(TokenType) +
+           offsets.capacity() * sizeof(uint32_t) +
+           lengths.capacity() * sizeof(uint32_t) +
+           symbols.capacity() * sizeof(Symbol) +
+           literalIndex.capacity() * sizeof(uint32_t) +
+           literals.capacity() * sizeof(Token);
+}
+
+Token TokenBuffer::token(size_t i) const {
+    if (hasPayload(types[i])) {
+        auto it = std::lower_bound(literalIndex.begin(), literalIndex.end(), static_cast<uint32_t>(i));
+        return literals[static_cast<size_t>(it - literalIndex.begin())];
+    }
+    Token tok{types[i], lexeme(i), offsets[i]};
+    if (tok.type == TokenType::Identifier) tok.symbol = symbols[i];
+    return tok;
+}
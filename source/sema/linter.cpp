@@ -0,0 +1,79 @@
+#include "linter.hpp"
+#include <algorithm>
+#include <string>
+
+void Linter::push(const ASTNode* node) {
+    if (node) work.push_back({node, false});
+}
+
+void Linter::pushList(const ASTList& list) {
+    for (size_t i = list.size(); i-- > 0;) push(list[i]);
+}
+
+void Linter::lint(const Function& fn, size_t offset, std::vector<Diagnostic>& diagnostics) {
+    locals.clear();
+    owners.assign(std::max<size_t>(fn.frameSize, fn.params.size()), unbound);
+
+    work.clear();
+    pushList(fn.body->statements);
+    while (!work.empty()) {
+        Work item = work.back();
+        work.pop_back();
+        if (!item.declare) {
+            visit(item.node);
+            continue;
+        }
+        auto let = static_cast<const LetDecl*>(item.node);
+        if (let->slot == unbound) continue;
+        owners[let->slot] = static_cast<uint32_t>(locals.size());
+        locals.push_back({let, false});
+    }
+
+    for (const Local& local : locals) {
+        std::string_view name = local.let->name.str();
+        if (local.used || name.empty() || name[0] == '_') continue;
+        diagnostics.push_back({DiagnosticStage::Lint, "Unused variable `" + std::string(name) + "`",
+                               offset + local.let->offset});
+    }
+}
+
+void Linter::visit(const ASTNode* node) {
+    switch (node->kind) {
+        case NodeKind::Var: {
+            uint32_t slot = static_cast<const VarExpr*>(node)->slot;
+            if (slot != unbound && owners[slot] != unbound) locals[owners[slot]].used = true;
+            break;
+        }
+        case NodeKind::Unary:
+            push(static_cast<const UnaryExpr*>(node)->operand);
+            break;
+        case NodeKind::Binary: {
+            auto n = static_cast<const BinaryExpr*>(node);
+            push(n->right);
+            push(n->left);
+            break;
+        }
+        case NodeKind::Call:
+            pushList(static_cast<const CallExpr*>(node)->args);
+            break;
+        case NodeKind::Return:
+            push(static_cast<const ReturnStmt*>(node)->value);
+            break;
+        case NodeKind::If: {
+            auto n = static_cast<const IfStmt*>(node);
+            pushList(n->elseBranch);
+            pushList(n->thenBranch);
+            push(n->cond);
+            break;
+        }
+        case NodeKind::Let:
+            work.push_back({node, true});
+            push(static_cast<const LetDecl*>(node)->init);
+            break;
+        case NodeKind::Block:
+            pushList(static_cast<const BlockStmt*>(node)->statements);
+            break;
+        default:
+            break;
+    }
+}
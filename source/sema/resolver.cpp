@@ -0,0 +1,129 @@
+#include "resolver.hpp"
+#include <algorithm>
+#include <string>
+
+static std::string quoted(Symbol name) {
+    return "`" + std::string(name.str()) + "`";
+}
+
+uint32_t& Resolver::binding(Symbol name) {
+    if (name.id >= innermost.size()) innermost.resize(name.id + 1, unbound);
+    return innermost[name.id];
+}
+
+uint32_t Resolver::lookup(Symbol name) const {
+    return name.id < innermost.size() ? innermost[name.id] : unbound;
+}
+
+uint32_t Resolver::declare(Symbol name, size_t offset) {
+    uint32_t& top = binding(name);
+    if (top != unbound && top >= scopes.back()) error("Redefinition of " + quoted(name), offset);
+    uint32_t slot = static_cast<uint32_t>(bindings.size());
+    bindings.push_back({name, top});
+    top = slot;
+    frameSize = std::max(frameSize, slot + 1);
+    return slot;
+}
+
+void Resolver::closeScope() {
+    uint32_t mark = scopes.back();
+    scopes.pop_back();
+    while (bindings.size() > mark) {
+        innermost[bindings.back().name.id] = bindings.back().shadowed;
+        bindings.pop_back();
+    }
+}
+
+void Resolver::error(std::string message, size_t offset) {
+    diags->push_back({DiagnosticStage::Resolver, std::move(message), base + offset});
+}
+
+void Resolver::pushList(const ASTList& list) {
+    for (size_t i = list.size(); i-- > 0;) work.push_back({Op::Visit, list[i]});
+}
+
+void Resolver::resolve(Function& fn, size_t offset, std::vector<Diagnostic>& diagnostics) {
+    base = offset;
+    diags = &diagnostics;
+    frameSize = 0;
+    scopes.push_back(0);
+    for (const Param& p : fn.params) declare(p.name, p.offset);
+
+    work.clear();
+    pushList(fn.body->statements);
+    while (!work.empty()) {
+        Work item = work.back();
+        work.pop_back();
+        switch (item.op) {
+            case Op::Visit:
+                if (item.node) visit(item.node);
+                break;
+            case Op::Declare: {
+                auto let = static_cast<LetDecl*>(item.node);
+                let->slot = declare(let->name, let->offset);
+                break;
+            }
+            case Op::OpenScope:
+                scopes.push_back(static_cast<uint32_t>(bindings.size()));
+                break;
+            case Op::CloseScope:
+                closeScope();
+                break;
+        }
+    }
+
+    closeScope();
+    fn.frameSize = frameSize;
+}
+
+void Resolver::visit(ASTNode* node) {
+    switch (node->kind) {
+        case NodeKind::Var: {
+            auto n = static_cast<VarExpr*>(node);
+            n->slot = lookup(n->name);
+            if (n->slot == unbound) error("Undefined variable " + quoted(n->name), n->offset);
+            break;
+        }
+        case NodeKind::Unary:
+            work.push_back({Op::Visit, static_cast<UnaryExpr*>(node)->operand});
+            break;
+        case NodeKind::Binary: {
+            auto n = static_cast<BinaryExpr*>(node);
+            work.push_back({Op::Visit, n->right});
+            work.push_back({Op::Visit, n->left});
+            break;
+        }
+        case NodeKind::Call: {
+            auto n = static_cast<CallExpr*>(node);
+            n->target = functions.find(n->callee);
+            if (n->target == unbound) error("Undefined function " + quoted(n->callee), n->offset);
+            pushList(n->args);
+            break;
+        }
+        case NodeKind::Return:
+            work.push_back({Op::Visit, static_cast<ReturnStmt*>(node)->value});
+            break;
+        case NodeKind::If: {
+            auto n = static_cast<IfStmt*>(node);
+            work.push_back({Op::CloseScope, nullptr});
+            pushList(n->elseBranch);
+            work.push_back({Op::OpenScope, nullptr});
+            work.push_back({Op::CloseScope, nullptr});
+            pushList(n->thenBranch);
+            work.push_back({Op::OpenScope, nullptr});
+            work.push_back({Op::Visit, n->cond});
+            break;
+        }
+        case NodeKind::Let:
+            work.push_back({Op::Declare, node});
+            work.push_back({Op::Visit, static_cast<LetDecl*>(node)->init});
+            break;
+        case NodeKind::Block:
+            work.push_back({Op::CloseScope, nullptr});
+            pushList(static_cast<BlockStmt*>(node)->statements);
+            work.push_back({Op::OpenScope, nullptr});
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,46 @@
+#include "sema.hpp"
+#include "linter.hpp"
+#include "resolver.hpp"
+#include "signature_table.hpp"
+#include "thread_pool.hpp"
+#include "type_checker.hpp"
+#include <algorithm>
+
+namespace {
+
+struct SemaWorker {
+    explicit SemaWorker(const SignatureTable& table) : resolver(table), checker(table) {}
+
+    Resolver resolver;
+    TypeChecker checker;
+    Linter linter;
+    std::vector<Diagnostic> diagnostics;
+};
+
+}
+
+void analyzeProgram(Program& program, std::vector<Diagnostic>& diagnostics, unsigned jobs) {
+    std::vector<Diagnostic> found;
+    SignatureTable table(program, found);
+
+    std::vector<SemaWorker> workers;
+    workers.reserve(std::max(jobs, 1u));
+    for (unsigned w = 0; w < std::max(jobs, 1u); w++) workers.emplace_back(table);
+
+    parallelFor(program.functions.size(), jobs, 64, [&](size_t i, unsigned worker) {
+        SemaWorker& sema = workers[worker];
+        Function& fn = *program.functions[i];
+        size_t offset = program.functionOffset(i);
+        sema.resolver.resolve(fn, offset, sema.diagnostics);
+        sema.checker.check(fn, offset, sema.diagnostics);
+        sema.linter.lint(fn, offset, sema.diagnostics);
+    });
+
+    for (const SemaWorker& sema : workers) found.insert(found.end(), sema.diagnostics.begin(), sema.diagnostics.end());
+    // Functions cover disjoint source ranges, so only diagnostics from the
+    // same function (and therefore the same worker, in pass order) can tie.
+    std::stable_sort(found.begin(), found.end(), [](const Diagnostic& a, const Diagnostic& b) {
+        return a.offset != b.offset ? a.offset < b.offset : a.stage < b.stage;
+    });
+    diagnostics.insert(diagnostics.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+}
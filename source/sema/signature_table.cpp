@@ -0,0 +1,14 @@
+#include "signature_table.hpp"
+#include <string>
+
+SignatureTable::SignatureTable(const Program& program, std::vector<Diagnostic>& diagnostics) {
+    signatures.reserve(program.functions.size());
+    indices.reserve(program.functions.size());
+    for (size_t i = 0; i < program.functions.size(); i++) {
+        const Function* fn = program.functions[i];
+        signatures.push_back({fn->name, fn->returnType, fn->params});
+        if (!indices.emplace(fn->name, static_cast<uint32_t>(i)).second)
+            diagnostics.push_back({DiagnosticStage::Resolver, "Redefinition of function `" + std::string(fn->name.str()) + "`",
+                                   program.functionOffset(i)});
+    }
+}
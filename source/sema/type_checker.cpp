@@ -0,0 +1,264 @@
+#include "type_checker.hpp"
+#include <algorithm>
+
+static std::string quoted(Symbol name) {
+    return "`" + std::string(name.str()) + "`";
+}
+
+static bool isNumeric(VarType t) {
+    return t == VarType::Int || t == VarType::Float;
+}
+
+static bool isAssignment(BinaryOp op) {
+    return op <= BinaryOp::DivAssign;
+}
+
+static bool assignable(VarType from, VarType to) {
+    return from == to || (from == VarType::Int && to == VarType::Float);
+}
+
+static BinaryOp compoundBase(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::AddAssign: return BinaryOp::Add;
+        case BinaryOp::SubAssign: return BinaryOp::Sub;
+        case BinaryOp::MulAssign: return BinaryOp::Mul;
+        case BinaryOp::DivAssign: return BinaryOp::Div;
+        default: return op;
+    }
+}
+
+// Sets out to the result type even when the operands do not fit, so a
+// failed expression still carries its most likely type.
+static bool binaryType(BinaryOp op, VarType l, VarType r, VarType& out) {
+    bool numeric = isNumeric(l) && isNumeric(r);
+    switch (op) {
+        case BinaryOp::Assign:
+            out = l;
+            return assignable(r, l);
+        case BinaryOp::AddAssign:
+        case BinaryOp::SubAssign:
+        case BinaryOp::MulAssign:
+        case BinaryOp::DivAssign: {
+            VarType value;
+            out = l;
+            return binaryType(compoundBase(op), l, r, value) && assignable(value, l);
+        }
+        case BinaryOp::Eq:
+        case BinaryOp::Neq:
+            out = VarType::Bool;
+            return numeric || l == r;
+        case BinaryOp::Less:
+        case BinaryOp::Greater:
+        case BinaryOp::Leq:
+        case BinaryOp::Geq:
+            out = VarType::Bool;
+            return numeric || (l == r && (l == VarType::Char || l == VarType::String));
+        case BinaryOp::Add:
+            if (l == VarType::String && r == VarType::String) {
+                out = VarType::String;
+                return true;
+            }
+            [[fallthrough]];
+        case BinaryOp::Sub:
+        case BinaryOp::Mul:
+        case BinaryOp::Div:
+            out = l == VarType::Float || r == VarType::Float ? VarType::Float : l;
+            return numeric;
+    }
+    out = l;
+    return false;
+}
+
+void TypeChecker::error(std::string message, const ASTNode& at) {
+    diags->push_back({DiagnosticStage::Types, std::move(message), base + at.offset});
+}
+
+void TypeChecker::push(ASTNode* node) {
+    if (node) work.push_back({node, false});
+}
+
+void TypeChecker::pushList(const ASTList& list) {
+    for (size_t i = list.size(); i-- > 0;) push(list[i]);
+}
+
+void TypeChecker::pushStatements(const ASTList& list) {
+    for (size_t i = list.size(); i-- > 0;) {
+        if (list[i]->kind <= NodeKind::Call) work.push_back({nullptr, true});
+        push(list[i]);
+    }
+}
+
+TypeChecker::Value TypeChecker::operand(const ASTNode* child) {
+    if (!child) return {VarType::Void, false};
+    Value v = values.back();
+    values.pop_back();
+    return v;
+}
+
+void TypeChecker::result(ASTNode* node, VarType type, bool valid) {
+    static_cast<Expr*>(node)->type = type;
+    values.push_back({type, valid});
+}
+
+void TypeChecker::check(Function& fn, size_t offset, std::vector<Diagnostic>& diagnostics) {
+    function = &fn;
+    base = offset;
+    diags = &diagnostics;
+    slots.assign(std::max<size_t>(fn.frameSize, fn.params.size()), VarType::Void);
+    for (size_t i = 0; i < fn.params.size(); i++) slots[i] = fn.params[i].type;
+
+    work.clear();
+    values.clear();
+    pushStatements(fn.body->statements);
+    while (!work.empty()) {
+        Work item = work.back();
+        work.pop_back();
+        if (!item.node) values.pop_back();
+        else if (item.leaving) leave(item.node);
+        else enter(item.node);
+    }
+}
+
+void TypeChecker::enter(ASTNode* node) {
+    work.push_back({node, true});
+    switch (node->kind) {
+        case NodeKind::Unary:
+            push(static_cast<UnaryExpr*>(node)->operand);
+            break;
+        case NodeKind::Binary: {
+            auto n = static_cast<BinaryExpr*>(node);
+            push(n->right);
+            push(n->left);
+            break;
+        }
+        case NodeKind::Call:
+            pushList(static_cast<CallExpr*>(node)->args);
+            break;
+        case NodeKind::Return:
+            push(static_cast<ReturnStmt*>(node)->value);
+            break;
+        case NodeKind::If: {
+            auto n = static_cast<IfStmt*>(node);
+            pushStatements(n->elseBranch);
+            pushStatements(n->thenBranch);
+            push(n->cond);
+            break;
+        }
+        case NodeKind::Let:
+            push(static_cast<LetDecl*>(node)->init);
+            break;
+        case NodeKind::Block:
+            pushStatements(static_cast<BlockStmt*>(node)->statements);
+            break;
+        default:
+            break;
+    }
+}
+
+void TypeChecker::leave(ASTNode* node) {
+    switch (node->kind) {
+        case NodeKind::Int: result(node, VarType::Int); break;
+        case NodeKind::Double: result(node, VarType::Float); break;
+        case NodeKind::String: result(node, VarType::String); break;
+        case NodeKind::Char: result(node, VarType::Char); break;
+        case NodeKind::Bool: result(node, VarType::Bool); break;
+        case NodeKind::Void: result(node, VarType::Void); break;
+        case NodeKind::Var: {
+            uint32_t slot = static_cast<VarExpr*>(node)->slot;
+            if (slot == unbound) result(node, VarType::Void, false);
+            else result(node, slots[slot]);
+            break;
+        }
+        case NodeKind::Unary: {
+            auto n = static_cast<UnaryExpr*>(node);
+            Value v = operand(n->operand);
+            bool ok = n->op == UnaryOp::Neg ? isNumeric(v.type) : v.type == VarType::Bool;
+            VarType type = n->op == UnaryOp::Neg ? v.type : VarType::Bool;
+            if (v.valid && !ok)
+                error(std::string("Operator `") + toString(n->op) + "` cannot be applied to " + toString(v.type), *n);
+            result(node, type, v.valid && ok);
+            break;
+        }
+        case NodeKind::Binary:
+            checkBinary(*static_cast<BinaryExpr*>(node));
+            break;
+        case NodeKind::Call:
+            checkCall(*static_cast<CallExpr*>(node));
+            break;
+        case NodeKind::Return: {
+            auto n = static_cast<ReturnStmt*>(node);
+            Value v = n->value ? operand(n->value) : Value{VarType::Void, true};
+            if (v.valid && !assignable(v.type, function->returnType))
+                error(quoted(function->name) + " returns " + toString(function->returnType) + ", got " +
+                      toString(v.type), *n);
+            break;
+        }
+        case NodeKind::If: {
+            auto n = static_cast<IfStmt*>(node);
+            Value v = operand(n->cond);
+            if (v.valid && v.type != VarType::Bool)
+                error(std::string("Condition must be Bool, got ") + toString(v.type), *n->cond);
+            break;
+        }
+        case NodeKind::Let: {
+            auto n = static_cast<LetDecl*>(node);
+            if (n->init) {
+                Value v = operand(n->init);
+                if (v.valid && !assignable(v.type, n->type))
+                    error("Cannot initialize " + quoted(n->name) + " of type " + toString(n->type) + " with " +
+                          toString(v.type), *n);
+            }
+            if (n->slot != unbound) slots[n->slot] = n->type;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void TypeChecker::checkBinary(BinaryExpr& n) {
+    Value right = operand(n.right);
+    Value left = operand(n.left);
+    bool assignment = isAssignment(n.op);
+    if (assignment && n.left && n.left->kind != NodeKind::Var) {
+        error(std::string("Left side of `") + toString(n.op) + "` is not a variable", n);
+        left.valid = false;
+    }
+
+    VarType type;
+    bool ok = binaryType(n.op, left.type, right.type, type);
+    bool valid = left.valid && right.valid;
+    if (valid && !ok) {
+        if (assignment)
+            error(std::string("Cannot assign ") + toString(right.type) + " to " + toString(left.type), n);
+        else
+            error(std::string("Operator `") + toString(n.op) + "` cannot be applied to " + toString(left.type) +
+                  " and " + toString(right.type), n);
+    }
+    result(&n, type, valid && ok);
+}
+
+void TypeChecker::checkCall(CallExpr& n) {
+    size_t count = n.args.size();
+    const Value* args = values.data() + values.size() - count;
+    if (n.target == unbound) {
+        values.resize(values.size() - count);
+        result(&n, VarType::Void, false);
+        return;
+    }
+
+    const Signature& callee = functions[n.target];
+    if (count != callee.params.size()) {
+        error(quoted(n.callee) + " expects " + std::to_string(callee.params.size()) + " argument" +
+              (callee.params.size() == 1 ? "" : "s") + ", got " + std::to_string(count), n);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            VarType expected = callee.params[i].type;
+            if (args[i].valid && !assignable(args[i].type, expected))
+                error("Argument " + std::to_string(i + 1) + " of " + quoted(n.callee) + " expects " +
+                      toString(expected) + ", got " + toString(args[i].type), *n.args[i]);
+        }
+    }
+    values.resize(values.size() - count);
+    result(&n, callee.returnType);
+}
@@ -0,0 +1,29 @@
+#include "arena.hpp"
+#include <cstring>
+
+Arena::Arena(size_t size) : slabSize(size) {}
+
+void* Arena::allocateSlow(size_t size, size_t align) {
+    size_t needed = size + align;
+    if (needed > slabSize / 4) {
+        slabs.emplace_back(new char[needed]);
+        reserved += needed;
+        used += size;
+        char* base = slabs.back().get();
+        size_t adjust = (align - reinterpret_cast<uintptr_t>(base) % align) % align;
+        return base + adjust;
+    }
+
+    slabs.emplace_back(new char[slabSize]);
+    reserved += slabSize;
+    cur = slabs.back().get();
+    end = cur + slabSize;
+    return allocate(size, align);
+}
+
+std::string_view Arena::copy(std::string_view s) {
+    if (s.empty()) return {};
+    char* p = allocateChars(s.size());
+    std::memcpy(p, s.data(), s.size());
+    return {p, s.size()};
+}
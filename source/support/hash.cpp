@@ -0,0 +1,75 @@
+#include "hash.hpp"
+#include <cstring>
+
+static constexpr uint64_t prime1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t prime3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+static constexpr uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+static uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t read64(const char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t read32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t mixLane(uint64_t acc, uint64_t input) {
+    acc += input * prime2;
+    return rotl(acc, 31) * prime1;
+}
+
+static uint64_t merge(uint64_t acc, uint64_t lane) {
+    acc ^= mixLane(0, lane);
+    return acc * prime1 + prime4;
+}
+
+uint64_t hash64(std::string_view data, uint64_t seed) {
+    const char* p = data.data();
+    const char* end = p + data.size();
+    uint64_t h;
+
+    if (data.size() >= 32) {
+        uint64_t v1 = seed + prime1 + prime2;
+        uint64_t v2 = seed + prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime1;
+        for (; end - p >= 32; p += 32) {
+            v1 = mixLane(v1, read64(p));
+            v2 = mixLane(v2, read64(p + 8));
+            v3 = mixLane(v3, read64(p + 16));
+            v4 = mixLane(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(h, v1);
+        h = merge(h, v2);
+        h = merge(h, v3);
+        h = merge(h, v4);
+    } else {
+        h = seed + prime5;
+    }
+    h += data.size();
+
+    for (; end - p >= 8; p += 8) h = rotl(h ^ mixLane(0, read64(p)), 27) * prime1 + prime4;
+    if (end - p >= 4) {
+        h = rotl(h ^ (read32(p) * prime1), 23) * prime2 + prime3;
+        p += 4;
+    }
+    for (; p < end; p++) h = rotl(h ^ (static_cast<unsigned char>(*p) * prime5), 11) * prime1;
+
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    h *= prime3;
+    h ^= h >> 32;
+    return h;
+}
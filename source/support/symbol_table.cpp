@@ -0,0 +1,87 @@
+#include "symbol_table.hpp"
+#include <stdexcept>
+
+SymbolTable::SymbolTable()
+    : chunks(new std::atomic<std::string_view*>[maxChunks]), slots(1024, Slot{0, emptySlot}) {
+    for (uint32_t i = 0; i < maxChunks; i++) chunks[i].store(nullptr, std::memory_order_relaxed);
+    intern({});
+}
+
+void SymbolTable::grow() {
+    std::vector<Slot> old(slots.size() * 2, Slot{0, emptySlot});
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.index == emptySlot) continue;
+        size_t i = slot.hash & mask;
+        while (slots[i].index != emptySlot) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
+
+Symbol SymbolTable::intern(std::string_view s, size_t hash) {
+    uint32_t tag = static_cast<uint32_t>(hash);
+    size_t mask = slots.size() - 1;
+    size_t i = tag & mask;
+    for (; slots[i].index != emptySlot; i = (i + 1) & mask) {
+        if (slots[i].hash == tag && str(Symbol{slots[i].index}) == s) return Symbol{slots[i].index};
+    }
+
+    uint32_t index = count.load(std::memory_order_relaxed);
+    if (index == capacity) throw std::length_error("Symbol table is full");
+    if ((index & (chunkSize - 1)) == 0) {
+        owned.emplace_back(new std::string_view[chunkSize]);
+        chunks[index >> chunkBits].store(owned.back().get(), std::memory_order_release);
+    }
+
+    std::string_view stored = storage.copy(s);
+    owned.back()[index & (chunkSize - 1)] = stored;
+    slots[i] = {tag, index};
+    count.store(index + 1, std::memory_order_release);
+    if (size_t(index + 1) * 2 > slots.size()) grow();
+    return Symbol{index};
+}
+
+ConcurrentSymbolTable::ConcurrentSymbolTable() = default;
+
+ConcurrentSymbolTable& ConcurrentSymbolTable::global() {
+    static ConcurrentSymbolTable table;
+    return table;
+}
+
+Symbol ConcurrentSymbolTable::intern(std::string_view s, size_t hash) {
+    if (s.empty()) return Symbol{};
+    uint32_t shard = static_cast<uint32_t>(hash >> (sizeof(size_t) * 8 - shardBits));
+    Shard& target = shards[shard];
+    std::lock_guard<std::mutex> guard(target.lock);
+    Symbol local = target.table.intern(s, hash);
+    return Symbol{(local.id << shardBits) | shard};
+}
+
+size_t ConcurrentSymbolTable::size() const {
+    size_t n = 1;
+    for (const Shard& shard : shards) n += shard.table.size() - 1;
+    return n;
+}
+
+namespace {
+
+struct CachedSymbol {
+    size_t hash = 0;
+    std::string_view text;
+    Symbol symbol;
+};
+
+constexpr size_t symbolCacheSize = 4096;
+
+}
+
+Symbol intern(std::string_view s) {
+    thread_local std::array<CachedSymbol, symbolCacheSize> cache;
+    size_t hash = std::hash<std::string_view>()(s);
+    CachedSymbol& slot = cache[hash & (symbolCacheSize - 1)];
+    if (slot.hash == hash && slot.text == s) return slot.symbol;
+    Symbol symbol = ConcurrentSymbolTable::global().intern(s, hash);
+    slot = {hash, symbol.str(), symbol};
+    return symbol;
+}
@@ -0,0 +1,87 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+unsigned defaultJobCount() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+namespace {
+
+struct alignas(64) WorkRange {
+    std::mutex lock;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+}
+
+// Each worker owns a contiguous slice of the index space and eats it from
+// the front in grain-sized chunks. A worker that runs dry steals the back
+// half of another worker's remaining slice, so uneven items still balance
+// while neighbouring indices mostly stay on the same thread.
+void parallelFor(size_t count, unsigned workers, size_t grain,
+                 const std::function<void(size_t, unsigned)>& body) {
+    grain = std::max<size_t>(grain, 1);
+    workers = static_cast<unsigned>(std::min<size_t>(std::max(workers, 1u), (count + grain - 1) / grain));
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; i++) body(i, 0);
+        return;
+    }
+
+    std::vector<WorkRange> ranges(workers);
+    for (unsigned w = 0; w < workers; w++) {
+        ranges[w].begin = count * w / workers;
+        ranges[w].end = count * (w + 1) / workers;
+    }
+
+    auto take = [&](unsigned worker, size_t& begin, size_t& end) {
+        WorkRange& own = ranges[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (own.begin == own.end) return false;
+        begin = own.begin;
+        end = std::min(own.end, begin + grain);
+        own.begin = end;
+        return true;
+    };
+
+    auto steal = [&](unsigned worker) {
+        for (unsigned k = 1; k < workers; k++) {
+            WorkRange& victim = ranges[(worker + k) % workers];
+            size_t begin;
+            size_t end;
+            {
+                std::lock_guard<std::mutex> guard(victim.lock);
+                size_t left = victim.end - victim.begin;
+                if (left <= grain) continue;
+                begin = victim.end - left / 2;
+                end = victim.end;
+                victim.end = begin;
+            }
+            WorkRange& own = ranges[worker];
+            std::lock_guard<std::mutex> guard(own.lock);
+            own.begin = begin;
+            own.end = end;
+            return true;
+        }
+        return false;
+    };
+
+    auto run = [&](unsigned worker) {
+        size_t begin;
+        size_t end;
+        do {
+            while (take(worker, begin, end))
+                for (size_t i = begin; i < end; i++) body(i, worker);
+        } while (steal(worker));
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (unsigned w = 1; w < workers; w++) threads.emplace_back(run, w);
+    run(0);
+    for (auto& t : threads) t.join();
+}